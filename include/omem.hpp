@@ -1,11 +1,85 @@
 #pragma once
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <new>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define OMEM_HAS_POSIX 1
+#define OMEM_HAS_GUARD 1
+#else
+#define OMEM_HAS_POSIX 0
+#define OMEM_HAS_GUARD 0
+#endif
+
+#ifndef OMEM_POOL_SIZE
+#define OMEM_POOL_SIZE 1048576
+#endif
+
+// Defined automatically under -fno-exceptions. Without exceptions, providers return nullptr on
+// failure, the std::nothrow overloads pass it on, and the throwing API aborts instead.
+#if !defined(OMEM_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && !defined(__EXCEPTIONS)
+#define OMEM_NO_EXCEPTIONS
+#endif
+
+#ifdef OMEM_NO_EXCEPTIONS
+#define OMEM_TRY if (true)
+#define OMEM_CATCH else
+#define OMEM_RETHROW std::abort()
+#else
+#define OMEM_TRY try
+#define OMEM_CATCH catch (...)
+#define OMEM_RETHROW throw
+#endif
 
 namespace omem
 {
+	namespace detail
+	{
+		[[noreturn]] inline void ThrowBadAlloc()
+		{
+#ifdef OMEM_NO_EXCEPTIONS
+			std::fputs("<omem>: Out of memory\n", stderr);
+			std::abort();
+#else
+			throw std::bad_alloc{};
+#endif
+		}
+
+		// How providers report failure: throws std::bad_alloc, or returns nullptr without exceptions.
+		[[nodiscard]] inline void* AllocFailed()
+		{
+#ifdef OMEM_NO_EXCEPTIONS
+			return nullptr;
+#else
+			throw std::bad_alloc{};
+#endif
+		}
+	}
+
 	template <class T1, class T2>
 	[[nodiscard]] constexpr T1 LogCeil(T1 x, T2 base) noexcept
 	{
@@ -20,7 +94,699 @@ namespace omem
 
 		return cnt + remain;
 	}
+
+	// Index of the lowest set bit. x must not be 0.
+	[[nodiscard]] inline unsigned CountTrailingZeros(uint64_t x) noexcept
+	{
+		assert(x != 0);
+#if defined(__GNUC__) || defined(__clang__)
+		return static_cast<unsigned>(__builtin_ctzll(x));
+#elif defined(_MSC_VER) && defined(_WIN64)
+		unsigned long i;
+		_BitScanForward64(&i, x);
+		return static_cast<unsigned>(i);
+#else
+		unsigned n = 0;
+		for (; !(x & 1); x >>= 1) ++n;
+		return n;
+#endif
+	}
 	
+	// Runtime tuning. Options are "key:value" pairs separated by commas, whitespace or newlines:
+	//   pool_size:1m        bytes reserved up front for every size class (rounded up to a power of two)
+	//   pool_size.64:256k   override for a single size class
+	//   min_size:16         smallest size class
+	//   huge_pages:true     default page mode of MmapChunkProvider
+	//   stats:1             statistics level; 2 enables sampled latency histograms
+	//   latency_sample:64   measure one in N allocations/frees when stats >= 2
+	//   guard_sample:0      place one in N allocations between guard pages (0 disables)
+	//   guard_slots:256     pages available to guarded allocations, process-wide
+	//   memory_budget:512m  bytes that pools of all managers may reserve and fault, process-wide (0 for none);
+	//                       past it managers trim their idle pools, then fail. Each class's up-front pool
+	//                       is capped at 1/64 of it.
+	//   cgroup_limit:false  don't take memory_budget from the cgroup v2 memory.high or memory.max of the process
+	// FromEnvironment() applies the file named by OMEM_CONF_FILE, then the OMEM_CONF environment
+	// variable, then reads the cgroup limit if cgroup_limit is set and memory_budget isn't.
+	struct Config
+	{
+		static constexpr size_t kMaxClasses = sizeof(size_t) * 8;
+		// PoolSize rounds up to a power of two; anything larger would not fit in a size_t.
+		static constexpr size_t kMaxPoolSize = size_t(1) << (kMaxClasses - 1);
+
+		size_t pool_size = OMEM_POOL_SIZE;
+		size_t class_pool_size[kMaxClasses]{};
+		size_t min_size = sizeof(void*);
+		bool huge_pages = false;
+		unsigned stats = 0;
+		unsigned latency_sample = 64;
+		unsigned guard_sample = 0;
+		size_t guard_slots = 256;
+		size_t memory_budget = 0;
+		bool cgroup_limit = true;
+
+		[[nodiscard]] static Config FromEnvironment()
+		{
+			return FromEnvironment(std::getenv("OMEM_CONF_FILE"), std::getenv("OMEM_CONF"));
+		}
+
+		// Same as above with the variables' values passed in; either may be null.
+		[[nodiscard]] static Config FromEnvironment(const char* path, const char* opts)
+		{
+			Config config;
+			if (path) config.ParseFile(path);
+			if (opts) config.Parse(opts);
+			if (config.cgroup_limit && !config.memory_budget) config.memory_budget = ReadCgroupLimit();
+			return config;
+		}
+
+		[[nodiscard]] size_t PoolSize(size_t log) const noexcept
+		{
+			const auto size = class_pool_size[log] ? class_pool_size[log] : pool_size;
+			if (!size) return 0;
+			auto ret = size_t(1) << LogCeil(size, 2);
+			if (memory_budget >= 64) ret = std::min(ret, size_t(1) << (LogCeil(memory_budget / 64 + 1, 2) - 1));
+			return ret;
+		}
+
+		// The lower of memory.high and memory.max of the cgroup v2 group listed in self, or 0 if the
+		// group has no limit or the files can't be read.
+		[[nodiscard]] static size_t ReadCgroupLimit(const char* root = "/sys/fs/cgroup", const char* self = "/proc/self/cgroup")
+		{
+			auto* const file = std::fopen(self, "r");
+			if (!file) return 0;
+			char line[512];
+			std::string_view group;
+			while (std::fgets(line, sizeof line, file))
+			{
+				std::string_view l{line};
+				if (l.substr(0, 3) != "0::") continue;
+				group = l.substr(3, l.find_last_not_of("\r\n") - 2);
+				break;
+			}
+			std::fclose(file);
+			if (group.empty()) return 0;
+
+			size_t limit = 0;
+			for (const auto* name : {"/memory.high", "/memory.max"})
+			{
+				char path[1024];
+				std::snprintf(path, sizeof path, "%s%.*s%s", root, static_cast<int>(group.size()), group.data(),
+					group == "/" ? name + 1 : name);
+				auto* const f = std::fopen(path, "r");
+				if (!f) continue;
+				unsigned long long value;
+				if (std::fscanf(f, "%llu", &value) == 1 && value > 0)
+					limit = limit ? std::min<size_t>(limit, value) : static_cast<size_t>(value);
+				std::fclose(f);
+			}
+			return limit;
+		}
+
+		void Parse(std::string_view opts)
+		{
+			constexpr std::string_view seps = ", \t\r\n";
+			while (!opts.empty())
+			{
+				const auto begin = opts.find_first_not_of(seps);
+				if (begin == opts.npos) break;
+				opts.remove_prefix(begin);
+
+				const auto pair = opts.substr(0, opts.find_first_of(seps));
+				opts.remove_prefix(pair.size());
+				if (pair[0] == '#')
+				{
+					opts.remove_prefix(std::min(opts.find('\n'), opts.size()));
+					continue;
+				}
+
+				const auto colon = pair.find(':');
+				if (colon == pair.npos || !Set(pair.substr(0, colon), pair.substr(colon + 1)))
+					std::fprintf(stderr, "<omem>: Invalid conf pair: %.*s\n", static_cast<int>(pair.size()), pair.data());
+			}
+		}
+
+		bool ParseFile(const char* path)
+		{
+			auto* const file = std::fopen(path, "r");
+			if (!file)
+			{
+				std::fprintf(stderr, "<omem>: Cannot open conf file: %s\n", path);
+				return false;
+			}
+
+			std::vector<char> buf;
+			for (size_t len = 0; ; len = buf.size())
+			{
+				buf.resize(len + 4096);
+				buf.resize(len + std::fread(buf.data() + len, 1, 4096, file));
+				if (buf.size() < len + 4096) break;
+			}
+			std::fclose(file);
+			Parse({buf.data(), buf.size()});
+			return true;
+		}
+
+		bool Set(std::string_view key, std::string_view value)
+		{
+			if (key == "huge_pages") return ParseBool(value, huge_pages);
+			if (key == "cgroup_limit") return ParseBool(value, cgroup_limit);
+
+			size_t num;
+			if (!ParseSize(value, num)) return false;
+
+			if (key == "pool_size" || key.substr(0, 10) == "pool_size.")
+			{
+				if (num > kMaxPoolSize) return false;
+			}
+
+			if (key == "pool_size") pool_size = num;
+			else if (key == "min_size") min_size = std::max(num, sizeof(void*));
+			else if (key == "stats") stats = static_cast<unsigned>(num);
+			else if (key == "latency_sample" && num > 0) latency_sample = static_cast<unsigned>(num);
+			else if (key == "guard_sample") guard_sample = static_cast<unsigned>(num);
+			else if (key == "guard_slots" && num > 0) guard_slots = num;
+			else if (key == "memory_budget") memory_budget = num;
+			else if (key.substr(0, 10) == "pool_size.")
+			{
+				size_t cls;
+				if (!ParseSize(key.substr(10), cls) || cls == 0) return false;
+				const auto log = LogCeil(cls, 2);
+				if (log >= kMaxClasses) return false;
+				class_pool_size[log] = num;
+			}
+			else return false;
+			return true;
+		}
+
+	private:
+		[[nodiscard]] static bool ParseBool(std::string_view value, bool& out) noexcept
+		{
+			if (value == "true" || value == "1") out = true;
+			else if (value == "false" || value == "0") out = false;
+			else return false;
+			return true;
+		}
+
+		[[nodiscard]] static bool ParseSize(std::string_view value, size_t& out) noexcept
+		{
+			if (value.empty()) return false;
+			size_t num = 0, i = 0;
+			for (; i < value.size() && value[i] >= '0' && value[i] <= '9'; ++i)
+			{
+				const size_t digit = value[i] - '0';
+				if (num > (SIZE_MAX - digit) / 10) return false;
+				num = num * 10 + digit;
+			}
+			if (i == 0) return false;
+
+			if (i + 1 == value.size())
+			{
+				unsigned shift;
+				switch (value[i] | 0x20)
+				{
+				case 'k': shift = 10; break;
+				case 'm': shift = 20; break;
+				case 'g': shift = 30; break;
+				default: return false;
+				}
+				if (num > (SIZE_MAX >> shift)) return false;
+				num <<= shift;
+			}
+			else if (i != value.size()) return false;
+
+			out = num;
+			return true;
+		}
+	};
+
+	[[nodiscard]] inline const Config& GetConfig()
+	{
+		static const auto config = Config::FromEnvironment();
+		return config;
+	}
+
+	// Cycle counter on x86, nanoseconds elsewhere.
+	[[nodiscard]] inline uint64_t ReadClock() noexcept
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	// Log-linear histogram: 8 linear sub-buckets per power of two.
+	// Written by a single thread, readable from any thread.
+	class LatencyHistogram
+	{
+	public:
+		static constexpr size_t kSubBits = 3;
+		static constexpr size_t kSub = size_t(1) << kSubBits;
+		static constexpr size_t kBuckets = (64 - kSubBits + 1) * kSub;
+
+		LatencyHistogram() noexcept = default;
+
+		LatencyHistogram(const LatencyHistogram& r) noexcept
+		{
+			Merge(r);
+		}
+
+		LatencyHistogram& operator=(const LatencyHistogram& r) noexcept
+		{
+			for (size_t i=0; i<kBuckets; ++i)
+				buckets_[i].store(r.buckets_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+			return *this;
+		}
+
+		void Record(uint64_t value) noexcept
+		{
+			auto& b = buckets_[BucketOf(value)];
+			b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+
+		void Merge(const LatencyHistogram& r) noexcept
+		{
+			for (size_t i=0; i<kBuckets; ++i)
+			{
+				const auto add = r.buckets_[i].load(std::memory_order_relaxed);
+				if (add) buckets_[i].store(buckets_[i].load(std::memory_order_relaxed) + add, std::memory_order_relaxed);
+			}
+		}
+
+		[[nodiscard]] uint64_t Count() const noexcept
+		{
+			uint64_t n = 0;
+			for (auto& b : buckets_) n += b.load(std::memory_order_relaxed);
+			return n;
+		}
+
+		[[nodiscard]] uint64_t CountAt(size_t bucket) const noexcept
+		{
+			return buckets_[bucket].load(std::memory_order_relaxed);
+		}
+
+		// Lower bound of the bucket containing the q-th quantile (0 <= q <= 1).
+		[[nodiscard]] uint64_t Percentile(double q) const noexcept
+		{
+			const auto total = Count();
+			if (total == 0) return 0;
+			const auto rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+			uint64_t seen = 0;
+			for (size_t i=0; i<kBuckets; ++i)
+				if ((seen += buckets_[i].load(std::memory_order_relaxed)) >= rank)
+					return BucketLower(i);
+			return BucketLower(kBuckets - 1);
+		}
+
+		[[nodiscard]] static constexpr size_t BucketOf(uint64_t value) noexcept
+		{
+			if (value < kSub) return static_cast<size_t>(value);
+			size_t log = 0;
+			for (auto v = value; v >>= 1;) ++log;
+			return (log - kSubBits + 1) * kSub + ((value >> (log - kSubBits)) & (kSub - 1));
+		}
+
+		[[nodiscard]] static constexpr uint64_t BucketLower(size_t bucket) noexcept
+		{
+			if (bucket < kSub) return bucket;
+			const auto log = bucket / kSub + kSubBits - 1;
+			return (uint64_t(1) << log) | (uint64_t(bucket % kSub) << (log - kSubBits));
+		}
+
+	private:
+		std::atomic<uint64_t> buckets_[kBuckets]{};
+	};
+
+	struct LatencyStats
+	{
+		LatencyHistogram alloc;
+		LatencyHistogram free;
+		LatencyHistogram fault;
+
+		void Merge(const LatencyStats& r) noexcept
+		{
+			alloc.Merge(r.alloc);
+			free.Merge(r.free);
+			fault.Merge(r.fault);
+		}
+	};
+
+	namespace detail
+	{
+		struct LatencyRegistry
+		{
+			std::mutex mutex;
+			std::vector<const LatencyStats*> threads;
+			LatencyStats retired;
+		};
+
+		[[nodiscard]] inline LatencyRegistry& GetLatencyRegistry()
+		{
+			static LatencyRegistry registry;
+			return registry;
+		}
+
+		struct ThreadLatency
+		{
+			ThreadLatency()
+			{
+				auto& reg = GetLatencyRegistry();
+				std::lock_guard<std::mutex> lock{reg.mutex};
+				reg.threads.push_back(&stats);
+			}
+
+			~ThreadLatency()
+			{
+				auto& reg = GetLatencyRegistry();
+				std::lock_guard<std::mutex> lock{reg.mutex};
+				reg.retired.Merge(stats);
+				reg.threads.erase(std::find(reg.threads.begin(), reg.threads.end(), &stats));
+			}
+
+			LatencyStats stats;
+			unsigned countdown = 1;
+		};
+
+		[[nodiscard]] inline ThreadLatency& GetThreadLatency()
+		{
+			thread_local ThreadLatency latency;
+			return latency;
+		}
+	}
+
+	namespace detail
+	{
+		struct ThreadBytes
+		{
+			uint64_t allocated = 0;
+			uint64_t deallocated = 0;
+		};
+
+		inline thread_local ThreadBytes thread_bytes;
+	}
+
+	// Bytes requested from and returned to every manager by the calling thread since it started.
+	// Both only grow; the pointers stay valid for the thread's lifetime, so reading is a single load.
+	[[nodiscard]] inline const uint64_t* ThreadAllocatedPtr() noexcept { return &detail::thread_bytes.allocated; }
+	[[nodiscard]] inline const uint64_t* ThreadDeallocatedPtr() noexcept { return &detail::thread_bytes.deallocated; }
+	[[nodiscard]] inline uint64_t ThreadAllocated() noexcept { return detail::thread_bytes.allocated; }
+	[[nodiscard]] inline uint64_t ThreadDeallocated() noexcept { return detail::thread_bytes.deallocated; }
+
+	// Counts the bytes the calling thread allocates and frees while the scope is alive. If out is
+	// given, the bytes allocated are written there when the scope ends.
+	class AllocationScope
+	{
+	public:
+		explicit AllocationScope(uint64_t* out = nullptr) noexcept
+			:allocated_{ThreadAllocated()}, deallocated_{ThreadDeallocated()}, out_{out}
+		{
+		}
+
+		~AllocationScope()
+		{
+			if (out_) *out_ = Allocated();
+		}
+
+		AllocationScope(const AllocationScope&) = delete;
+		AllocationScope& operator=(const AllocationScope&) = delete;
+
+		[[nodiscard]] uint64_t Allocated() const noexcept { return ThreadAllocated() - allocated_; }
+		[[nodiscard]] uint64_t Deallocated() const noexcept { return ThreadDeallocated() - deallocated_; }
+
+	private:
+		uint64_t allocated_;
+		uint64_t deallocated_;
+		uint64_t* out_;
+	};
+
+	// Latencies sampled by every manager of every thread, including exited ones.
+	[[nodiscard]] inline LatencyStats GetLatencyStats()
+	{
+		auto& reg = detail::GetLatencyRegistry();
+		std::lock_guard<std::mutex> lock{reg.mutex};
+		auto stats = reg.retired;
+		for (auto* t : reg.threads) stats.Merge(*t);
+		return stats;
+	}
+
+	namespace detail
+	{
+#if OMEM_HAS_GUARD
+		// Home of sampled allocations (GWP-ASan style). Each slot is one page between PROT_NONE guard
+		// pages, with the block placed against the upper guard so that overflows fault immediately.
+		// Freed slots are protected again and reused oldest first, so use-after-free faults for as
+		// long as possible. Faults in the region are reported to stderr before the previous SIGSEGV
+		// action runs; other faults go straight to the previous handler.
+		class GuardedRegion
+		{
+			enum class State : uint8_t { kFree, kLive, kFreed };
+
+			struct Slot
+			{
+				uintptr_t addr = 0;
+				size_t size = 0;
+				State state = State::kFree;
+			};
+
+		public:
+			// Shared by every manager that samples. The first user maps the region and installs the
+			// SIGSEGV handler, deciding the number of slots; the last one unmaps it and restores the
+			// previous handler, unless guarded blocks are still live.
+			[[nodiscard]] static GuardedRegion* Acquire(size_t slots)
+			{
+				std::lock_guard<std::mutex> lock{users_mutex_};
+				if (!instance_) instance_ = new GuardedRegion{slots};
+				++instance_->users_;
+				return instance_;
+			}
+
+			void Release() noexcept
+			{
+				std::lock_guard<std::mutex> lock{users_mutex_};
+				if (--users_) return;
+				{
+					std::lock_guard<std::mutex> guard{mutex_};
+					if (free_count_ != slots_.size() && bytes_.load(std::memory_order_relaxed)) return;
+				}
+				instance_ = nullptr;
+				delete this;
+			}
+
+			[[nodiscard]] static bool Owns(const void* p) noexcept
+			{
+				return reinterpret_cast<uintptr_t>(p) - base_.load(std::memory_order_relaxed)
+					< bytes_.load(std::memory_order_relaxed);
+			}
+
+			// Returns nullptr if the block doesn't fit a page or every slot is in use.
+			[[nodiscard]] void* Alloc(size_t size) noexcept
+			{
+				if (size > page_) return nullptr;
+				std::lock_guard<std::mutex> lock{mutex_};
+				if (free_count_ == 0) return nullptr;
+
+				const auto i = queue_[head_];
+				auto* const page = SlotPage(i);
+				if (mprotect(page, page_, PROT_READ | PROT_WRITE) != 0) return nullptr;
+				head_ = (head_ + 1) % slots_.size();
+				--free_count_;
+
+				auto& s = slots_[i];
+				const auto rounded = std::min((std::max<size_t>(size, 1) + 15) & ~size_t(15), page_);
+				s.addr = reinterpret_cast<uintptr_t>(page) + page_ - rounded;
+				s.size = size;
+				s.state = State::kLive;
+				return reinterpret_cast<void*>(s.addr);
+			}
+
+			// Double and invalid frees are reported and abort.
+			void Free(void* p) noexcept
+			{
+				std::lock_guard<std::mutex> lock{mutex_};
+				const auto a = reinterpret_cast<uintptr_t>(p);
+				const auto i = SlotOf(a);
+				auto& s = slots_[i];
+				if (s.state != State::kLive || s.addr != a)
+				{
+					Report(s.state == State::kFreed && s.addr == a ? "double free" : "invalid free", a, s);
+					std::abort();
+				}
+
+				mprotect(SlotPage(i), page_, PROT_NONE);
+				s.state = State::kFreed;
+				queue_[(head_ + free_count_) % slots_.size()] = i;
+				++free_count_;
+			}
+
+		private:
+			explicit GuardedRegion(size_t slots)
+				:page_{static_cast<size_t>(sysconf(_SC_PAGESIZE))}, slots_(slots), queue_(slots), free_count_{slots}
+			{
+				const auto bytes = (2 * slots + 1) * page_;
+				auto* const base = mmap(nullptr, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+				if (base == MAP_FAILED)
+				{
+					free_count_ = 0;
+					return;
+				}
+				for (size_t i=0; i<slots; ++i) queue_[i] = i;
+
+				if (!installed_)
+				{
+					struct sigaction sa{};
+					sa.sa_sigaction = &OnSignal;
+					sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+					sigemptyset(&sa.sa_mask);
+					sigaction(SIGSEGV, &sa, &previous_);
+					installed_ = true;
+				}
+
+				base_.store(reinterpret_cast<uintptr_t>(base), std::memory_order_relaxed);
+				bytes_.store(bytes, std::memory_order_relaxed);
+			}
+
+			~GuardedRegion()
+			{
+				const auto bytes = bytes_.load(std::memory_order_relaxed);
+				if (!bytes) return;
+
+				// Leave the handler alone if someone installed theirs over ours.
+				struct sigaction current{};
+				sigaction(SIGSEGV, nullptr, &current);
+				if ((current.sa_flags & SA_SIGINFO) && current.sa_sigaction == &OnSignal)
+				{
+					sigaction(SIGSEGV, &previous_, nullptr);
+					installed_ = false;
+				}
+
+				auto* const base = reinterpret_cast<void*>(base_.load(std::memory_order_relaxed));
+				bytes_.store(0, std::memory_order_relaxed);
+				base_.store(0, std::memory_order_relaxed);
+				munmap(base, bytes);
+			}
+
+			[[nodiscard]] char* SlotPage(size_t i) const noexcept
+			{
+				return reinterpret_cast<char*>(base_.load(std::memory_order_relaxed)) + (2 * i + 1) * page_;
+			}
+
+			// A guard page is attributed to the block below it unless that slot was never used.
+			[[nodiscard]] size_t SlotOf(uintptr_t a) const noexcept
+			{
+				const auto page = (a - base_.load(std::memory_order_relaxed)) / page_;
+				if (page % 2) return page / 2;
+				const auto above = std::min(page / 2, slots_.size() - 1);
+				return page > 0 && slots_[page / 2 - 1].state != State::kFree ? page / 2 - 1 : above;
+			}
+
+			// Called from the signal handler, so the line is formatted by hand and written with write().
+			void Report(const char* what, uintptr_t a, const Slot& s) const noexcept
+			{
+				char buf[256];
+				size_t len = 0;
+				const auto put = [&](const char* str)
+				{
+					while (*str && len < sizeof buf) buf[len++] = *str++;
+				};
+				const auto num = [&](uintptr_t x, unsigned base)
+				{
+					char digits[24];
+					size_t n = 0;
+					do digits[n++] = "0123456789abcdef"[x % base]; while (x /= base);
+					if (base == 16) put("0x");
+					while (n && len < sizeof buf) buf[len++] = digits[--n];
+				};
+
+				put("<omem>: ");
+				put(what);
+				put(" at ");
+				num(a, 16);
+				put(" on ");
+				num(s.size, 10);
+				put("-byte guarded block ");
+				num(s.addr, 16);
+				put(s.state == State::kLive ? " (live)\n" : s.state == State::kFreed ? " (freed)\n" : " (never allocated)\n");
+				(void)!write(STDERR_FILENO, buf, len);
+			}
+
+			static void OnSignal(int sig, siginfo_t* info, void* context)
+			{
+				auto* const r = instance_;
+				const auto& previous = previous_;
+				const auto a = reinterpret_cast<uintptr_t>(info->si_addr);
+				if (r && Owns(info->si_addr))
+				{
+					const auto& s = r->slots_[r->SlotOf(a)];
+					const auto* what = s.state == State::kFree ? "wild access"
+						: s.state == State::kFreed ? "use-after-free"
+						: a >= s.addr + s.size ? "buffer overflow" : "buffer underflow";
+					r->Report(what, a, s);
+				}
+				else if (previous.sa_flags & SA_SIGINFO)
+				{
+					// Someone else's fault: chain to their handler and stay installed.
+					return previous.sa_sigaction(sig, info, context);
+				}
+				else if (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN)
+				{
+					return previous.sa_handler(sig);
+				}
+				// Returning re-runs the faulting access under the previous (default) action.
+				sigaction(SIGSEGV, &previous, nullptr);
+			}
+
+			static inline std::atomic<uintptr_t> base_{0};
+			static inline std::atomic<size_t> bytes_{0};
+			static inline GuardedRegion* instance_ = nullptr;
+			static inline std::mutex users_mutex_;
+			// Kept across teardown for a handler installed over ours that still chains to it.
+			static inline struct sigaction previous_{};
+			static inline bool installed_ = false;
+
+			std::mutex mutex_;
+			size_t users_ = 0;
+			size_t page_;
+			std::vector<Slot> slots_;
+			std::vector<size_t> queue_;
+			size_t head_ = 0;
+			size_t free_count_;
+		};
+#else
+		class GuardedRegion
+		{
+		public:
+			[[nodiscard]] static GuardedRegion* Acquire(size_t) { static GuardedRegion region; return &region; }
+			void Release() noexcept {}
+			[[nodiscard]] static bool Owns(const void*) noexcept { return false; }
+			[[nodiscard]] void* Alloc(size_t) noexcept { return nullptr; }
+			void Free(void*) noexcept {}
+		};
+#endif
+
+		struct GuardedRegionRelease
+		{
+			void operator()(GuardedRegion* r) const noexcept { r->Release(); }
+		};
+	}
+
+	namespace detail
+	{
+		inline std::atomic<size_t> budget_used{0};
+	}
+
+	// Bytes currently reserved and faulted by pools that have a memory budget, process-wide.
+	[[nodiscard]] inline size_t MemoryBudgetUsed() noexcept
+	{
+		return detail::budget_used.load(std::memory_order_relaxed);
+	}
+
+	// Whether p was placed in the guarded region by a manager with guard_sample set.
+	[[nodiscard]] inline bool IsGuarded(const void* p) noexcept
+	{
+		return detail::GuardedRegion::Owns(p);
+	}
+
 	struct PoolInfo
 	{
 		constexpr PoolInfo() noexcept = default;
@@ -37,111 +803,443 @@ namespace omem
 		size_t fault = 0;
 	};
 	
-	class MemoryPool
+	// Chunk providers supply the backing memory of pools: both the pool buffer and faulted blocks.
+	// Allocate() throws std::bad_alloc on failure, just like operator new, or returns nullptr when
+	// built without exceptions (see detail::AllocFailed()).
+	struct NewChunkProvider
+	{
+#ifdef OMEM_NO_EXCEPTIONS
+		[[nodiscard]] void* Allocate(size_t size) noexcept { return operator new(size, std::nothrow); }
+#else
+		[[nodiscard]] void* Allocate(size_t size) { return operator new(size); }
+#endif
+		void Deallocate(void* p, size_t) noexcept { operator delete(p); }
+	};
+
+	class ChunkResource
 	{
 	public:
-		MemoryPool(size_t size, size_t count)
-			:next_{nullptr}, blocks_{nullptr}, info_{size, count}
+		virtual ~ChunkResource() = default;
+		[[nodiscard]] virtual void* Allocate(size_t size) = 0;
+		virtual void Deallocate(void* p, size_t size) noexcept = 0;
+	};
+
+	namespace detail
+	{
+		template <class Provider, class = void>
+		struct HasReallocate : std::false_type {};
+
+		// Optional provider capability: void* Reallocate(void* p, size_t old_size, size_t new_size)
+		template <class Provider>
+		struct HasReallocate<Provider, std::void_t<decltype(std::declval<Provider&>().Reallocate(nullptr, 0, 0))>>
+			: std::true_type {};
+	}
+
+	template <class Provider>
+	class ChunkProviderResource final : public ChunkResource
+	{
+	public:
+		explicit ChunkProviderResource(Provider provider = {})
+			:provider_{std::move(provider)}
 		{
-			assert(size >= sizeof(Block));
-			if (count == 0) return;
+		}
 
-			blocks_ = operator new(size * count);
-			
-			auto* it = static_cast<char*>(blocks_);
-			auto* next = next_ = static_cast<Block*>(blocks_);
-			
-			for (size_t i=1; i<count; ++i)
-				next = next->next = reinterpret_cast<Block*>(it += size);
-			
-			next->next = nullptr;
+		[[nodiscard]] void* Allocate(size_t size) override { return provider_.Allocate(size); }
+		void Deallocate(void* p, size_t size) noexcept override { provider_.Deallocate(p, size); }
+
+	private:
+		Provider provider_;
+	};
+
+	[[nodiscard]] inline ChunkResource& DefaultChunkResource() noexcept
+	{
+		static ChunkProviderResource<NewChunkProvider> resource;
+		return resource;
+	}
+
+	// Type-erased provider. Does not own the resource, which must outlive every pool using it.
+	class AnyChunkProvider
+	{
+	public:
+		AnyChunkProvider() noexcept
+			:resource_{&DefaultChunkResource()}
+		{
+		}
+
+		AnyChunkProvider(ChunkResource& resource) noexcept
+			:resource_{&resource}
+		{
+		}
+
+		[[nodiscard]] void* Allocate(size_t size) { return resource_->Allocate(size); }
+		void Deallocate(void* p, size_t size) noexcept { resource_->Deallocate(p, size); }
+		[[nodiscard]] ChunkResource& GetResource() const noexcept { return *resource_; }
+
+	private:
+		ChunkResource* resource_;
+	};
+
+	// Observers receive pool events at compile time; empty hooks are inlined away.
+	//   OnAlloc/OnFree/OnFault(info, block)  - OnFault is called instead of OnAlloc
+	//   OnGrow/OnTrim(info, chunk, bytes)    - the pool buffer was acquired or released
+	// Every pool holds its own copy, so observers used with a manager must be stateless and keep
+	// their data elsewhere (thread_local, like the ones in observer.hpp).
+	struct NullObserver
+	{
+		void OnAlloc(const PoolInfo&, void*) noexcept {}
+		void OnFree(const PoolInfo&, void*) noexcept {}
+		void OnFault(const PoolInfo&, void*) noexcept {}
+		void OnGrow(const PoolInfo&, void*, size_t) noexcept {}
+		void OnTrim(const PoolInfo&, void*, size_t) noexcept {}
+	};
+
+	// With a budget, the pool buffer and faulted blocks are charged to MemoryBudgetUsed(). Once they
+	// would take it past the budget, the buffer isn't reserved and faults fail like the provider does.
+	template <class Provider = NewChunkProvider, class Observer = NullObserver>
+	class BasicMemoryPool
+	{
+	public:
+		BasicMemoryPool(size_t size, size_t count, Provider provider = {}, Observer observer = {}, size_t budget = 0)
+			:next_{nullptr}, blocks_{nullptr}, info_{size, count}, used_{0},
+			provider_{std::move(provider)}, observer_{std::move(observer)}, budget_{budget}
+		{
+			assert(size >= sizeof(Block));
+			if (count != 0) Grow();
 		}
 		
-		MemoryPool(MemoryPool&& r) noexcept
-			:next_{r.next_}, blocks_{r.blocks_}, info_{r.info_}
+		BasicMemoryPool(BasicMemoryPool&& r) noexcept
+			:next_{r.next_}, blocks_{r.blocks_}, info_{r.info_}, used_{r.used_},
+			provider_{std::move(r.provider_)}, observer_{std::move(r.observer_)}, budget_{r.budget_}
 		{
 			r.next_ = nullptr;
 			r.blocks_ = nullptr;
-			info_ = {};
+			r.info_ = {};
+			r.used_ = 0;
 		}
 		
-		~MemoryPool()
+		~BasicMemoryPool()
 		{
-			if (blocks_) operator delete(blocks_);
+			if (!blocks_) return;
+			provider_.Deallocate(blocks_, info_.size * info_.count);
+			Uncharge(info_.size * info_.count);
 		}
 
-		MemoryPool& operator=(MemoryPool&& r) noexcept
+		BasicMemoryPool& operator=(BasicMemoryPool&& r) noexcept
 		{
-			MemoryPool{std::move(r)}.swap(*this);
+			BasicMemoryPool{std::move(r)}.swap(*this);
 			return *this;
 		}
 
-		MemoryPool(const MemoryPool&) = delete;
-		MemoryPool& operator=(const MemoryPool&) = delete;
+		BasicMemoryPool(const BasicMemoryPool&) = delete;
+		BasicMemoryPool& operator=(const BasicMemoryPool&) = delete;
 
 		[[nodiscard]] void* Alloc()
 		{
-			info_.peak = std::max(info_.peak, ++info_.cur);
-			if (next_)
+			if (auto* const ret = TryAlloc()) return ret;
+			if (auto* const ret = Fault()) return ret;
+			detail::ThrowBadAlloc();
+		}
+
+		// Returns nullptr instead of throwing when the provider fails.
+		[[nodiscard]] void* Alloc(std::nothrow_t) noexcept
+		{
+			OMEM_TRY
 			{
-				auto* ret = next_;
-				next_ = next_->next;
-				return ret;
+				if (auto* const ret = TryAlloc()) return ret;
+				return Fault();
 			}
-			++info_.fault;
-			return operator new(info_.size);
+			OMEM_CATCH { return nullptr; }
+		}
+
+		// Returns nullptr instead of faulting. Re-acquires the buffer if it was trimmed.
+		[[nodiscard]] void* TryAlloc() noexcept(noexcept(std::declval<Observer&>().OnAlloc(std::declval<const PoolInfo&>(), nullptr)))
+		{
+			if (!next_)
+			{
+				if (blocks_ || info_.count == 0) return nullptr;
+				OMEM_TRY { Grow(); }
+				OMEM_CATCH { return nullptr; }
+				if (!next_) return nullptr;
+			}
+			info_.peak = std::max(info_.peak, ++info_.cur);
+			++used_;
+			auto* ret = next_;
+			next_ = next_->next;
+			observer_.OnAlloc(info_, ret);
+			return ret;
 		}
 
 		void Free(void* ptr) noexcept
 		{
 			auto* const block = static_cast<Block*>(ptr);
-			const auto diff = static_cast<char*>(ptr) - static_cast<char*>(blocks_);
-			if (static_cast<size_t>(diff) < info_.count * info_.size)
+			--info_.cur;
+			observer_.OnFree(info_, ptr);
+			if (Owns(ptr))
 			{
 				auto* next = next_;
 				next_ = block;
 				block->next = next;
+				--used_;
 			}
 			else
 			{
-				operator delete(ptr);
+				provider_.Deallocate(ptr, info_.size);
+				Uncharge(info_.size);
+			}
+		}
+
+		// Hands a faulted block over to another pool, resizing it with the provider's Reallocate().
+		[[nodiscard]] void* MoveFault(void* ptr, BasicMemoryPool& to)
+		{
+			assert(!Owns(ptr));
+			if (!to.Charge(to.info_.size)) return nullptr;
+			void* ret;
+			OMEM_TRY { ret = provider_.Reallocate(ptr, info_.size, to.info_.size); }
+			OMEM_CATCH { to.Uncharge(to.info_.size); OMEM_RETHROW; }
+			if (!ret)
+			{
+				to.Uncharge(to.info_.size);
+				return nullptr;
 			}
+			Uncharge(info_.size);
 			--info_.cur;
+			observer_.OnFree(info_, ptr);
+			++to.info_.fault;
+			to.info_.peak = std::max(to.info_.peak, ++to.info_.cur);
+			to.observer_.OnFault(to.info_, ret);
+			return ret;
+		}
+
+		// Releases the pool buffer if none of its blocks are in use. Returns the bytes released.
+		size_t Trim() noexcept
+		{
+			if (!blocks_ || used_ != 0) return 0;
+			const auto bytes = info_.size * info_.count;
+			observer_.OnTrim(info_, blocks_, bytes);
+			provider_.Deallocate(blocks_, bytes);
+			Uncharge(bytes);
+			blocks_ = nullptr;
+			next_ = nullptr;
+			return bytes;
+		}
+		
+		[[nodiscard]] bool Owns(const void* ptr) const noexcept
+		{
+			const auto diff = static_cast<const char*>(ptr) - static_cast<const char*>(blocks_);
+			return static_cast<size_t>(diff) < info_.count * info_.size;
 		}
 		
 		[[nodiscard]] const PoolInfo& GetInfo() const noexcept { return info_; }
+		[[nodiscard]] size_t GetReserved() const noexcept { return blocks_ ? info_.size * info_.count : 0; }
+		[[nodiscard]] Provider& GetProvider() noexcept { return provider_; }
+		[[nodiscard]] Observer& GetObserver() noexcept { return observer_; }
+		[[nodiscard]] size_t GetBudget() const noexcept { return budget_; }
 
-		void swap(MemoryPool& r) noexcept
+		void swap(BasicMemoryPool& r) noexcept
 		{
 			using std::swap;
 			swap(next_, r.next_);
 			swap(blocks_, r.blocks_);
 			swap(info_, r.info_);
+			swap(used_, r.used_);
+			swap(provider_, r.provider_);
+			swap(observer_, r.observer_);
+			swap(budget_, r.budget_);
 		}
 
 	private:
+		[[nodiscard]] bool Charge(size_t bytes) noexcept
+		{
+			if (!budget_) return true;
+			const auto used = detail::budget_used.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+			if (used >= bytes && used <= budget_) return true;
+			detail::budget_used.fetch_sub(bytes, std::memory_order_relaxed);
+			return false;
+		}
+
+		void Uncharge(size_t bytes) noexcept
+		{
+			if (budget_) detail::budget_used.fetch_sub(bytes, std::memory_order_relaxed);
+		}
+
+		// Allocates from the provider, or returns nullptr if that would pass the budget.
+		void* Acquire(size_t bytes)
+		{
+			if (!Charge(bytes)) return nullptr;
+			void* ret;
+			OMEM_TRY { ret = provider_.Allocate(bytes); }
+			OMEM_CATCH { Uncharge(bytes); OMEM_RETHROW; }
+			if (!ret) Uncharge(bytes);
+			return ret;
+		}
+
+		void* Fault()
+		{
+			auto* const ret = Acquire(info_.size);
+			if (!ret) return nullptr;
+			++info_.fault;
+			info_.peak = std::max(info_.peak, ++info_.cur);
+			observer_.OnFault(info_, ret);
+			return ret;
+		}
+
+		void Grow()
+		{
+			const auto size = info_.size, count = info_.count;
+			blocks_ = Acquire(size * count);
+			if (!blocks_) return;
+			
+			auto* it = static_cast<char*>(blocks_);
+			auto* next = next_ = static_cast<Block*>(blocks_);
+			
+			for (size_t i=1; i<count; ++i)
+				next = next->next = reinterpret_cast<Block*>(it += size);
+			
+			next->next = nullptr;
+			observer_.OnGrow(info_, blocks_, size * count);
+		}
+
 		struct Block { Block* next; } *next_;
 		void* blocks_;
 		PoolInfo info_;
+		size_t used_;
+		Provider provider_;
+		Observer observer_;
+		size_t budget_;
 	};
 
-	class MemoryPoolManager
+	using MemoryPool = BasicMemoryPool<>;
+
+	// Offset of the Elem array that follows a T in a block from NewWithTrailing().
+	template <class T, class Elem>
+	constexpr size_t kTrailingOffset = (sizeof(T) + alignof(Elem) - 1) & ~(alignof(Elem) - 1);
+
+	// The array that follows an object created by NewWithTrailing<T, Elem>().
+	template <class Elem, class T>
+	[[nodiscard]] Elem* Trailing(T* p) noexcept
+	{
+		return reinterpret_cast<Elem*>(reinterpret_cast<char*>(p) + kTrailingOffset<T, Elem>);
+	}
+
+	template <class Elem, class T>
+	[[nodiscard]] const Elem* Trailing(const T* p) noexcept
 	{
+		return reinterpret_cast<const Elem*>(reinterpret_cast<const char*>(p) + kTrailingOffset<T, Elem>);
+	}
+
+	// Not thread-safe. A manager may move between threads, or be shared under the caller's own lock.
+	// With a memory_budget, an allocation that would pass it trims the idle pools and tries once more.
+	template <class Provider = NewChunkProvider, class Observer = NullObserver>
+	class BasicMemoryPoolManager
+	{
+		static_assert(std::is_empty_v<Observer>, "each pool gets a copy of the observer, so it must be stateless");
+
 	public:
+		using Pool = BasicMemoryPool<Provider, Observer>;
+
+		BasicMemoryPoolManager()
+			:BasicMemoryPoolManager{GetConfig()}
+		{
+		}
+
+		explicit BasicMemoryPoolManager(Provider provider, Observer observer = {})
+			:BasicMemoryPoolManager{GetConfig(), std::move(provider), std::move(observer)}
+		{
+		}
+
+		explicit BasicMemoryPoolManager(const Config& config, Provider provider = {}, Observer observer = {})
+			:provider_{std::move(provider)}, observer_{std::move(observer)},
+			min_log_{std::max(LogCeil(config.min_size, 2), LogCeil(sizeof(void*), 2))},
+			latency_sample_{config.stats >= 2 ? config.latency_sample : 0},
+			guard_sample_{OMEM_HAS_GUARD ? config.guard_sample : 0},
+			budget_{config.memory_budget}
+		{
+			if (guard_sample_)
+			{
+				guarded_.reset(detail::GuardedRegion::Acquire(config.guard_slots));
+				guard_countdown_ = static_cast<unsigned>(ReadClock() % guard_sample_) + 1;
+			}
+			for (size_t i=0; i<Config::kMaxClasses; ++i)
+				pool_size_[i] = config.PoolSize(i);
+		}
+
 		template <class T, class... Args>
 		[[nodiscard]] T* New(Args&&... args)
 		{
 			auto* const p = Alloc(sizeof(T));
-			try { return new (p) T{std::forward<Args>(args)...}; }
-			catch (...) { Free(p, sizeof(T)); throw; }
+			OMEM_TRY { return new (p) T{std::forward<Args>(args)...}; }
+			OMEM_CATCH { Free(p, sizeof(T)); OMEM_RETHROW; }
 		}
 
 		template <class T, class... Args>
 		[[nodiscard]] T* NewArr(size_t n, Args&&... args)
 		{
+			if (n > SIZE_MAX / sizeof(T)) detail::ThrowBadAlloc();
 			const auto p = Alloc(n * sizeof(T));
-			try { return new (p) T[n]{std::forward<Args>(args)...}; }
-			catch (...) { Free(p, n * sizeof(T)); throw; }
+			OMEM_TRY { return new (p) T[n]{std::forward<Args>(args)...}; }
+			OMEM_CATCH { Free(p, n * sizeof(T)); OMEM_RETHROW; }
+		}
+
+		// Return nullptr if memory runs out. Exceptions from constructors still propagate, as with
+		// new (std::nothrow), so these are noexcept exactly when construction is.
+		template <class T, class... Args>
+		[[nodiscard]] T* New(std::nothrow_t, Args&&... args) noexcept(noexcept(T{std::declval<Args>()...}))
+		{
+			auto* const p = Alloc(sizeof(T), std::nothrow);
+			if (!p) return nullptr;
+			if constexpr (noexcept(T{std::declval<Args>()...})) return new (p) T{std::forward<Args>(args)...};
+			else
+			{
+				OMEM_TRY { return new (p) T{std::forward<Args>(args)...}; }
+				OMEM_CATCH { Free(p, sizeof(T)); OMEM_RETHROW; }
+			}
+		}
+
+		template <class T, class... Args>
+		[[nodiscard]] T* NewArr(std::nothrow_t, size_t n, Args&&... args) noexcept(noexcept(T{std::declval<Args>()...}))
+		{
+			if (n > SIZE_MAX / sizeof(T)) return nullptr;
+			const auto p = Alloc(n * sizeof(T), std::nothrow);
+			if (!p) return nullptr;
+			if constexpr (noexcept(T{std::declval<Args>()...})) return new (p) T[n]{std::forward<Args>(args)...};
+			else
+			{
+				OMEM_TRY { return new (p) T[n]{std::forward<Args>(args)...}; }
+				OMEM_CATCH { Free(p, n * sizeof(T)); OMEM_RETHROW; }
+			}
+		}
+
+		// Allocates a T followed by n value-initialized Elems in one block; see Trailing().
+		// The elements are constructed first so that T's constructor may fill them.
+		template <class T, class Elem, class... Args>
+		[[nodiscard]] T* NewWithTrailing(size_t n, Args&&... args)
+		{
+			static_assert(alignof(T) <= alignof(std::max_align_t) && alignof(Elem) <= alignof(std::max_align_t));
+			if (n > (SIZE_MAX - kTrailingOffset<T, Elem>) / sizeof(Elem)) detail::ThrowBadAlloc();
+			const auto size = kTrailingOffset<T, Elem> + n * sizeof(Elem);
+			auto* const p = Alloc(size);
+			auto* const elems = reinterpret_cast<Elem*>(static_cast<char*>(p) + kTrailingOffset<T, Elem>);
+			size_t i = 0;
+			OMEM_TRY
+			{
+				for (; i<n; ++i) new (elems + i) Elem();
+				return new (p) T{std::forward<Args>(args)...};
+			}
+			OMEM_CATCH
+			{
+				while (i) elems[--i].~Elem();
+				Free(p, size);
+				OMEM_RETHROW;
+			}
+		}
+
+		template <class T, class Elem>
+		void DeleteWithTrailing(T* p, size_t n) noexcept
+		{
+			auto* const elems = Trailing<Elem>(p);
+			p->~T();
+			for (size_t i=0; i<n; ++i) elems[i].~Elem();
+			Free(p, kTrailingOffset<T, Elem> + n * sizeof(Elem));
 		}
 
 		template <class T>
@@ -160,26 +1258,189 @@ namespace omem
 
 		[[nodiscard]] void* Alloc(size_t size)
 		{
-			return Get(size).Alloc();
+			void* p = nullptr;
+			if (guard_countdown_ && --guard_countdown_ == 0) p = GuardedAlloc(size);
+			if (!p) p = latency_sample_ ? SampledAlloc(size) : PoolAlloc(Get(size));
+			detail::thread_bytes.allocated += size;
+			return p;
+		}
+
+		// Returns nullptr instead of throwing when memory runs out. Not latency-sampled.
+		[[nodiscard]] void* Alloc(size_t size, std::nothrow_t) noexcept
+		{
+			// Get() would throw, which aborts without exceptions.
+			if (size > size_t(1) << (Config::kMaxClasses - 1)) return nullptr;
+			if (guard_countdown_ && --guard_countdown_ == 0)
+			{
+				if (auto* const p = GuardedAlloc(size))
+				{
+					detail::thread_bytes.allocated += size;
+					return p;
+				}
+			}
+			OMEM_TRY
+			{
+				auto& pool = Get(size);
+				auto* p = pool.Alloc(std::nothrow);
+				if (!p && budget_ && Trim()) p = pool.Alloc(std::nothrow);
+				if (p) detail::thread_bytes.allocated += size;
+				return p;
+			}
+			OMEM_CATCH { return nullptr; }
 		}
 
 		void Free(void* p, size_t size) noexcept
 		{
+			detail::thread_bytes.deallocated += size;
+			if (guard_sample_ && IsGuarded(p)) return guarded_->Free(p);
+			if (latency_sample_) return SampledFree(p, size);
 			Get(size).Free(p);
 		}
+
+		// Resizes a block whose contents are trivially relocatable. The block stays in place while the
+		// size class doesn't change. Faulted blocks moving to an unpooled class are resized by the
+		// provider when it supports Reallocate() (mremap for MmapChunkProvider); otherwise contents are copied.
+		[[nodiscard]] void* Realloc(void* p, size_t old_size, size_t new_size)
+		{
+			if (guard_sample_ && IsGuarded(p))
+			{
+				auto* const ret = Alloc(new_size);
+				std::memcpy(ret, p, std::min(old_size, new_size));
+				detail::thread_bytes.deallocated += old_size;
+				guarded_->Free(p);
+				return ret;
+			}
+
+			auto& from = Get(old_size);
+			auto& to = Get(new_size);
+			auto* const ret = &from == &to ? p : Move(p, from, to, std::min(old_size, new_size));
+			detail::thread_bytes.allocated += new_size;
+			detail::thread_bytes.deallocated += old_size;
+			return ret;
+		}
+
+		// Bytes actually available in a block allocated for size bytes. Sizes past the largest class,
+		// which Alloc() rejects, are returned as they are.
+		[[nodiscard]] size_t UsableSize(size_t size) const noexcept
+		{
+			const auto log = std::max(LogCeil(size, 2), min_log_);
+			return log < Config::kMaxClasses ? size_t(1) << log : size;
+		}
 		
-		MemoryPool& Get(size_t size)
+		Pool& Get(size_t size)
 		{
-			constexpr auto pool_size = size_t(1) << LogCeil(OMEM_POOL_SIZE, 2);
-			constexpr auto min_log = LogCeil(sizeof(void*), 2);
-			const auto log = std::max(LogCeil(size, 2), min_log);
-			const auto real_size = size_t(1) << log;
-			return pools_.try_emplace(log, real_size, pool_size/real_size).first->second;
+			const auto log = std::max(LogCeil(size, 2), min_log_);
+			if (log >= Config::kMaxClasses) detail::ThrowBadAlloc();
+			auto it = pools_.find(log);
+			if (it == pools_.end())
+			{
+				const auto real_size = size_t(1) << log;
+				it = pools_.try_emplace(log, real_size, pool_size_[log]/real_size, provider_, observer_, budget_).first;
+			}
+			return it->second;
+		}
+
+		// Releases the buffers of all pools that have no block in use. Returns the bytes released.
+		size_t Trim() noexcept
+		{
+			size_t bytes = 0;
+			for (auto& [log, pool] : pools_) bytes += pool.Trim();
+			return bytes;
 		}
 
 		[[nodiscard]] auto& Pools() const noexcept { return pools_; }
 
 	private:
-		std::unordered_map<size_t, MemoryPool> pools_;
+		void* PoolAlloc(Pool& pool)
+		{
+			if (!budget_) return pool.Alloc();
+			if (auto* const p = pool.Alloc(std::nothrow)) return p;
+			if (Trim())
+				if (auto* const p = pool.Alloc(std::nothrow)) return p;
+			detail::ThrowBadAlloc();
+		}
+
+		void* Move(void* p, Pool& from, Pool& to, size_t bytes)
+		{
+			if constexpr (detail::HasReallocate<Provider>::value)
+			{
+				if (to.GetInfo().count == 0 && !from.Owns(p))
+				{
+					if (auto* const ret = from.MoveFault(p, to)) return ret;
+					if (budget_ && Trim())
+						if (auto* const ret = from.MoveFault(p, to)) return ret;
+					detail::ThrowBadAlloc();
+				}
+			}
+
+			auto* const ret = PoolAlloc(to);
+			std::memcpy(ret, p, bytes);
+			from.Free(p);
+			return ret;
+		}
+
+		void* GuardedAlloc(size_t size) noexcept
+		{
+			guard_countdown_ = guard_sample_;
+			return guarded_->Alloc(size);
+		}
+
+		// Every fault is timed since faults are rare and expensive; regular operations are sampled.
+		void* SampledAlloc(size_t size)
+		{
+			auto& t = detail::GetThreadLatency();
+			if (--t.countdown == 0)
+			{
+				t.countdown = latency_sample_;
+				const auto start = ReadClock();
+				auto& pool = Get(size);
+				const auto fault = pool.GetInfo().fault;
+				auto* const p = PoolAlloc(pool);
+				const auto elapsed = ReadClock() - start;
+				(pool.GetInfo().fault != fault ? t.stats.fault : t.stats.alloc).Record(elapsed);
+				return p;
+			}
+
+			auto& pool = Get(size);
+			if (auto* const p = pool.TryAlloc()) return p;
+			const auto start = ReadClock();
+			auto* const p = PoolAlloc(pool);
+			t.stats.fault.Record(ReadClock() - start);
+			return p;
+		}
+
+		void SampledFree(void* p, size_t size) noexcept
+		{
+			auto& t = detail::GetThreadLatency();
+			if (--t.countdown == 0)
+			{
+				t.countdown = latency_sample_;
+				const auto start = ReadClock();
+				Get(size).Free(p);
+				t.stats.free.Record(ReadClock() - start);
+				return;
+			}
+			Get(size).Free(p);
+		}
+
+		std::unordered_map<size_t, Pool> pools_;
+		Provider provider_;
+		Observer observer_;
+		size_t pool_size_[Config::kMaxClasses];
+		size_t min_log_;
+		unsigned latency_sample_;
+		unsigned guard_sample_;
+		unsigned guard_countdown_ = 0;
+		size_t budget_;
+		std::unique_ptr<detail::GuardedRegion, detail::GuardedRegionRelease> guarded_;
 	};
+
+	using MemoryPoolManager = BasicMemoryPoolManager<>;
+
+	// The calling thread's manager. Blocks must be freed on the thread that allocated them.
+	[[nodiscard]] inline MemoryPoolManager& ThreadPools()
+	{
+		thread_local MemoryPoolManager pools;
+		return pools;
+	}
 }
@@ -0,0 +1,276 @@
+#pragma once
+#include <cassert>
+#include <thread>
+#include <utility>
+#include <omem.hpp>
+
+namespace omem
+{
+	namespace detail
+	{
+		// Debug-build thread affinity check. Binds to the first thread that checks it.
+		class ThreadOwner
+		{
+		public:
+			void Check() noexcept
+			{
+#ifndef NDEBUG
+				const auto id = std::this_thread::get_id();
+				if (owner_ == std::thread::id{}) owner_ = id;
+				assert(owner_ == id && "omem: used from a thread that doesn't own it");
+#endif
+			}
+
+			void Unbind() noexcept
+			{
+#ifndef NDEBUG
+				owner_ = {};
+#endif
+			}
+
+		private:
+#ifndef NDEBUG
+			std::thread::id owner_;
+#endif
+		};
+	}
+
+	template <class Provider>
+	class BasicArena;
+
+	// Chunks detached from an arena. Owns them independently of any thread, so it can be passed to
+	// another thread and either released there wholesale or adopted by another arena.
+	template <class Provider = NewChunkProvider>
+	class ArenaBlocks
+	{
+		friend BasicArena<Provider>;
+
+	public:
+		ArenaBlocks() noexcept = default;
+
+		ArenaBlocks(ArenaBlocks&& r) noexcept
+			:head_{std::exchange(r.head_, nullptr)}, tail_{std::exchange(r.tail_, nullptr)},
+			bytes_{std::exchange(r.bytes_, 0)}, provider_{std::move(r.provider_)}
+		{
+		}
+
+		~ArenaBlocks()
+		{
+			Release();
+		}
+
+		ArenaBlocks& operator=(ArenaBlocks&& r) noexcept
+		{
+			ArenaBlocks{std::move(r)}.swap(*this);
+			return *this;
+		}
+
+		ArenaBlocks(const ArenaBlocks&) = delete;
+		ArenaBlocks& operator=(const ArenaBlocks&) = delete;
+
+		// Returns every chunk to the provider. Destructors of objects in them are not run.
+		void Release() noexcept;
+
+		[[nodiscard]] bool Empty() const noexcept { return !head_; }
+		[[nodiscard]] size_t Reserved() const noexcept { return bytes_; }
+
+		void swap(ArenaBlocks& r) noexcept
+		{
+			using std::swap;
+			swap(head_, r.head_);
+			swap(tail_, r.tail_);
+			swap(bytes_, r.bytes_);
+			swap(provider_, r.provider_);
+		}
+
+	private:
+		struct Chunk
+		{
+			Chunk* next;
+			size_t size;
+		};
+
+		ArenaBlocks(Chunk* head, Chunk* tail, size_t bytes, Provider provider) noexcept
+			:head_{head}, tail_{tail}, bytes_{bytes}, provider_{std::move(provider)}
+		{
+		}
+
+		Chunk* head_ = nullptr;
+		Chunk* tail_ = nullptr;
+		size_t bytes_ = 0;
+		Provider provider_;
+	};
+
+	template <class Provider>
+	void ArenaBlocks<Provider>::Release() noexcept
+	{
+		for (auto* c = head_; c;)
+		{
+			auto* const next = c->next;
+			provider_.Deallocate(c, c->size);
+			c = next;
+		}
+		head_ = tail_ = nullptr;
+		bytes_ = 0;
+	}
+
+	// Bump allocator over provider chunks. Objects are never freed individually; instead the whole
+	// chunk set is Reset() for reuse, or handed to another thread in O(1) with Detach(). Chunks
+	// taken back with Adopt() stay live until the next Reset(), after which they are reused.
+	// It belongs to one thread at a time, which debug builds assert.
+	template <class Provider = NewChunkProvider>
+	class BasicArena
+	{
+		using Chunk = typename ArenaBlocks<Provider>::Chunk;
+
+		static constexpr uintptr_t AlignUp(uintptr_t x, size_t a) noexcept { return (x + a - 1) & ~(a - 1); }
+
+		static constexpr size_t kHeader = AlignUp(sizeof(Chunk), alignof(std::max_align_t));
+
+	public:
+		explicit BasicArena(size_t chunk_size = 64 << 10, Provider provider = {})
+			:chunk_size_{chunk_size}, provider_{std::move(provider)}
+		{
+		}
+
+		~BasicArena()
+		{
+			Release();
+		}
+
+		BasicArena(const BasicArena&) = delete;
+		BasicArena& operator=(const BasicArena&) = delete;
+
+		[[nodiscard]] void* Alloc(size_t size, size_t align = alignof(std::max_align_t))
+		{
+			owner_.Check();
+			auto p = AlignUp(cur_, align);
+			if (!end_ || p + size > end_)
+			{
+				NewChunk(size + align);
+				p = AlignUp(cur_, align);
+			}
+			cur_ = p + size;
+			return reinterpret_cast<void*>(p);
+		}
+
+		// Destructors of arena objects are never run.
+		template <class T, class... Args>
+		[[nodiscard]] T* New(Args&&... args)
+		{
+			return new (Alloc(sizeof(T), alignof(T))) T{std::forward<Args>(args)...};
+		}
+
+		// Hands over every chunk holding live objects. The arena keeps only its spare chunks.
+		[[nodiscard]] ArenaBlocks<Provider> Detach() noexcept
+		{
+			owner_.Check();
+			ArenaBlocks<Provider> blocks{used_, used_tail_, used_bytes_, provider_};
+			used_ = used_tail_ = nullptr;
+			used_bytes_ = 0;
+			cur_ = end_ = 0;
+			return blocks;
+		}
+
+		// Takes ownership of detached chunks without touching their contents.
+		void Adopt(ArenaBlocks<Provider>&& blocks) noexcept
+		{
+			owner_.Check();
+			if (!blocks.head_) return;
+			if (used_tail_) used_tail_->next = blocks.head_;
+			else used_ = blocks.head_;
+			used_tail_ = blocks.tail_;
+			used_bytes_ += blocks.bytes_;
+			blocks.head_ = blocks.tail_ = nullptr;
+			blocks.bytes_ = 0;
+		}
+
+		// Discards every object and keeps all chunks as spares.
+		void Reset() noexcept
+		{
+			owner_.Check();
+			Recycle();
+		}
+
+		// Discards every object and returns all chunks, spares included, to the provider.
+		void Release() noexcept
+		{
+			Recycle();
+			for (auto* c = spare_; c;)
+			{
+				auto* const next = c->next;
+				provider_.Deallocate(c, c->size);
+				c = next;
+			}
+			spare_ = nullptr;
+			spare_bytes_ = 0;
+		}
+
+		// Gives up thread ownership; the next thread to use the arena becomes its owner.
+		void Unbind() noexcept { owner_.Unbind(); }
+
+		[[nodiscard]] size_t Reserved() const noexcept { return used_bytes_ + spare_bytes_; }
+		[[nodiscard]] size_t Used() const noexcept { return used_bytes_; }
+
+	private:
+		void Recycle() noexcept
+		{
+			if (used_tail_)
+			{
+				used_tail_->next = spare_;
+				spare_ = used_;
+				spare_bytes_ += used_bytes_;
+			}
+			used_ = used_tail_ = nullptr;
+			used_bytes_ = 0;
+			cur_ = end_ = 0;
+		}
+
+		void NewChunk(size_t min_size)
+		{
+			// Best fit, so that small requests don't take a spare chunk made for a large one.
+			Chunk** best = nullptr;
+			for (auto** prev = &spare_; *prev; prev = &(*prev)->next)
+			{
+				const auto size = (*prev)->size;
+				if (size >= min_size + kHeader && (!best || size < (*best)->size)) best = prev;
+				if (best && (*best)->size <= chunk_size_) break;
+			}
+
+			Chunk* c;
+			if (best)
+			{
+				c = *best;
+				*best = c->next;
+				spare_bytes_ -= c->size;
+			}
+			else
+			{
+				const auto size = std::max(chunk_size_, min_size + kHeader);
+				c = static_cast<Chunk*>(provider_.Allocate(size));
+				if (!c) detail::ThrowBadAlloc();
+				c->size = size;
+			}
+
+			c->next = used_;
+			used_ = c;
+			if (!used_tail_) used_tail_ = c;
+			used_bytes_ += c->size;
+			cur_ = reinterpret_cast<uintptr_t>(c) + kHeader;
+			end_ = reinterpret_cast<uintptr_t>(c) + c->size;
+		}
+
+		uintptr_t cur_ = 0;
+		uintptr_t end_ = 0;
+		Chunk* used_ = nullptr;
+		Chunk* used_tail_ = nullptr;
+		Chunk* spare_ = nullptr;
+		size_t used_bytes_ = 0;
+		size_t spare_bytes_ = 0;
+		size_t chunk_size_;
+		Provider provider_;
+		detail::ThreadOwner owner_;
+	};
+
+	using Arena = BasicArena<>;
+}
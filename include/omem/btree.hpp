@@ -0,0 +1,565 @@
+#pragma once
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <omem.hpp>
+
+namespace omem
+{
+	// Ordered map stored as a B+ tree. Every node is exactly NodeBytes (a power-of-two size class)
+	// with keys, values and child pointers packed into parallel arrays sized to fill it, and all
+	// nodes come from the map's own MemoryPools. Freed nodes go on a map-wide free list that is used
+	// before any pool. Entries live in the leaves, which are linked for scans. Inserting and erasing
+	// invalidate iterators.
+	template <class K, class V, class Compare = std::less<K>, size_t NodeBytes = 256>
+	class BTreeMap
+	{
+		static_assert((NodeBytes & (NodeBytes - 1)) == 0, "NodeBytes must be a power of two");
+		static_assert(alignof(K) <= alignof(std::max_align_t) && alignof(V) <= alignof(std::max_align_t));
+		static_assert(std::is_nothrow_move_constructible_v<K> && std::is_nothrow_move_assignable_v<K>
+			&& std::is_nothrow_move_constructible_v<V> && std::is_nothrow_move_assignable_v<V>,
+			"entries are shifted between nodes with moves that must not throw");
+
+		struct Node
+		{
+			uint16_t size;
+			bool leaf;
+			Node* next;
+		};
+
+		static constexpr size_t Align(size_t x, size_t a) noexcept { return (x + a - 1) & ~(a - 1); }
+
+		static constexpr size_t kKeyOffset = Align(sizeof(Node), alignof(K));
+
+		static constexpr size_t LeafBytes(size_t n) noexcept
+		{
+			return Align(Align(kKeyOffset + n * sizeof(K), alignof(V)) + n * sizeof(V), alignof(Node));
+		}
+
+		static constexpr size_t InnerBytes(size_t n) noexcept
+		{
+			return Align(kKeyOffset + n * sizeof(K), alignof(Node*)) + (n + 1) * sizeof(Node*);
+		}
+
+		static constexpr size_t LeafCapacity() noexcept
+		{
+			auto n = NodeBytes / (sizeof(K) + sizeof(V));
+			while (n && LeafBytes(n) > NodeBytes) --n;
+			return n;
+		}
+
+		static constexpr size_t InnerCapacity() noexcept
+		{
+			auto n = NodeBytes / (sizeof(K) + sizeof(Node*));
+			while (n && InnerBytes(n) > NodeBytes) --n;
+			return n;
+		}
+
+	public:
+		static constexpr size_t kLeafCapacity = LeafCapacity();
+		static constexpr size_t kInnerCapacity = InnerCapacity();
+		static_assert(kLeafCapacity >= 4 && kInnerCapacity >= 4, "NodeBytes too small for K and V");
+
+	private:
+		static constexpr size_t kLeafMin = kLeafCapacity / 2;
+		static constexpr size_t kInnerMin = (kInnerCapacity - 1) / 2;
+		static constexpr size_t kValueOffset = Align(kKeyOffset + kLeafCapacity * sizeof(K), alignof(V));
+		static constexpr size_t kChildOffset = Align(kKeyOffset + kInnerCapacity * sizeof(K), alignof(Node*));
+		static constexpr size_t kMaxDepth = 64;
+		static constexpr size_t kFirstPoolBytes = 4096;
+
+		static K* Keys(Node* n) noexcept { return reinterpret_cast<K*>(reinterpret_cast<char*>(n) + kKeyOffset); }
+		static V* Values(Node* n) noexcept { return reinterpret_cast<V*>(reinterpret_cast<char*>(n) + kValueOffset); }
+		static Node** Children(Node* n) noexcept { return reinterpret_cast<Node**>(reinterpret_cast<char*>(n) + kChildOffset); }
+
+	public:
+		template <bool Const>
+		class Iterator
+		{
+			friend BTreeMap;
+			template <bool> friend class Iterator;
+			using Mapped = std::conditional_t<Const, const V, V>;
+
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::pair<const K&, Mapped&>;
+			using difference_type = ptrdiff_t;
+			using pointer = void;
+			using reference = value_type;
+
+			Iterator() noexcept = default;
+			template <bool C, class = std::enable_if_t<Const && !C>>
+			Iterator(const Iterator<C>& r) noexcept :leaf_{r.leaf_}, i_{r.i_} {}
+
+			[[nodiscard]] const K& Key() const noexcept { return Keys(leaf_)[i_]; }
+			[[nodiscard]] Mapped& Value() const noexcept { return Values(leaf_)[i_]; }
+			reference operator*() const noexcept { return {Key(), Value()}; }
+
+			Iterator& operator++() noexcept
+			{
+				if (++i_ == leaf_->size)
+				{
+					leaf_ = leaf_->next;
+					i_ = 0;
+				}
+				return *this;
+			}
+
+			Iterator operator++(int) noexcept { auto t = *this; ++*this; return t; }
+
+			bool operator==(const Iterator& r) const noexcept { return leaf_ == r.leaf_ && i_ == r.i_; }
+			bool operator!=(const Iterator& r) const noexcept { return !(*this == r); }
+
+		private:
+			Iterator(Node* leaf, size_t i) noexcept :leaf_{leaf}, i_{i} {}
+
+			Node* leaf_ = nullptr;
+			size_t i_ = 0;
+		};
+
+		using iterator = Iterator<false>;
+		using const_iterator = Iterator<true>;
+
+		explicit BTreeMap(Compare comp = {})
+			:comp_{std::move(comp)}
+		{
+		}
+
+		BTreeMap(BTreeMap&& r) noexcept
+			:pools_{std::move(r.pools_)}, comp_{std::move(r.comp_)}, free_{std::exchange(r.free_, nullptr)},
+			root_{std::exchange(r.root_, nullptr)}, first_{std::exchange(r.first_, nullptr)},
+			size_{std::exchange(r.size_, 0)}
+		{
+		}
+
+		~BTreeMap()
+		{
+			Clear();
+		}
+
+		BTreeMap& operator=(BTreeMap&& r) noexcept
+		{
+			BTreeMap{std::move(r)}.swap(*this);
+			return *this;
+		}
+
+		BTreeMap(const BTreeMap&) = delete;
+		BTreeMap& operator=(const BTreeMap&) = delete;
+
+		template <class... Args>
+		std::pair<iterator, bool> TryEmplace(const K& key, Args&&... args)
+		{
+			Node* path[kMaxDepth];
+			size_t slots[kMaxDepth];
+			size_t depth = 0;
+			auto* n = root_;
+			size_t i = 0;
+			if (n)
+			{
+				for (; !n->leaf; n = Children(n)[slots[depth++]])
+				{
+					path[depth] = n;
+					slots[depth] = UpperBound(n, key);
+				}
+				i = LowerBound(n, key);
+				if (i < n->size && !comp_(key, Keys(n)[i])) return {{n, i}, false};
+			}
+
+			// Everything that can throw happens before the tree is touched.
+			K k(key);
+			V v(std::forward<Args>(args)...);
+
+			if (!n)
+			{
+				root_ = first_ = NewNode(true);
+				new (Keys(root_)) K(std::move(k));
+				new (Values(root_)) V(std::move(v));
+				root_->size = 1;
+				size_ = 1;
+				return {{root_, 0}, true};
+			}
+
+			if (n->size < kLeafCapacity)
+			{
+				InsertAt(Keys(n), n->size, i, std::move(k));
+				InsertAt(Values(n), n->size, i, std::move(v));
+				++n->size;
+				++size_;
+				return {{n, i}, true};
+			}
+
+			// The leaf splits, as does every full ancestor above it, and a new root is needed when
+			// they all are.
+			auto nodes = size_t(1);
+			while (nodes <= depth && path[depth - nodes]->size == kInnerCapacity) ++nodes;
+			ReserveNodes(nodes + (nodes > depth));
+
+			constexpr auto mid = kLeafCapacity / 2;
+			K separator(Keys(n)[mid]);
+			auto* const right = NewNode(true);
+			MoveRange(Keys(n) + mid, kLeafCapacity - mid, Keys(right));
+			MoveRange(Values(n) + mid, kLeafCapacity - mid, Values(right));
+			n->size = mid;
+			right->size = kLeafCapacity - mid;
+			right->next = n->next;
+			n->next = right;
+
+			iterator ret{n, i};
+			if (i > mid) ret = {right, i - mid};
+			InsertAt(Keys(ret.leaf_), ret.leaf_->size, ret.i_, std::move(k));
+			InsertAt(Values(ret.leaf_), ret.leaf_->size, ret.i_, std::move(v));
+			++ret.leaf_->size;
+			++size_;
+
+			InsertUp(path, slots, depth, std::move(separator), right);
+			return {ret, true};
+		}
+
+		std::pair<iterator, bool> Insert(const K& key, const V& value) { return TryEmplace(key, value); }
+		std::pair<iterator, bool> Insert(const K& key, V&& value) { return TryEmplace(key, std::move(value)); }
+
+		V& operator[](const K& key) { return TryEmplace(key).first.Value(); }
+
+		// Returns whether the key was present. If copying a separator key throws, the entry stays
+		// erased and the node it was in is left underfull, which later erases fix.
+		bool Erase(const K& key)
+		{
+			if (!root_) return false;
+
+			Node* path[kMaxDepth];
+			size_t slots[kMaxDepth];
+			size_t depth = 0;
+			auto* n = root_;
+			for (; !n->leaf; n = Children(n)[slots[depth++]])
+			{
+				path[depth] = n;
+				slots[depth] = UpperBound(n, key);
+			}
+
+			const auto i = LowerBound(n, key);
+			if (i == n->size || comp_(key, Keys(n)[i])) return false;
+
+			EraseAt(Keys(n), n->size, i);
+			EraseAt(Values(n), n->size, i);
+			--n->size;
+			--size_;
+
+			if (n == root_)
+			{
+				if (n->size == 0)
+				{
+					FreeNode(n);
+					root_ = first_ = nullptr;
+				}
+				return true;
+			}
+
+			while (depth && n->size < (n->leaf ? kLeafMin : kInnerMin))
+			{
+				--depth;
+				n = Rebalance(path[depth], slots[depth]);
+			}
+
+			if (!root_->leaf && root_->size == 0)
+			{
+				auto* const old = root_;
+				root_ = Children(old)[0];
+				FreeNode(old);
+			}
+			return true;
+		}
+
+		[[nodiscard]] iterator LowerBound(const K& key) noexcept { return LowerBoundImpl(key); }
+		[[nodiscard]] const_iterator LowerBound(const K& key) const noexcept { return LowerBoundImpl(key); }
+
+		[[nodiscard]] iterator Find(const K& key) noexcept { return FindImpl(key); }
+		[[nodiscard]] const_iterator Find(const K& key) const noexcept { return FindImpl(key); }
+		[[nodiscard]] bool Contains(const K& key) const noexcept { return Find(key) != end(); }
+
+		void Clear() noexcept
+		{
+			if (root_) Destroy(root_);
+			root_ = first_ = nullptr;
+			size_ = 0;
+		}
+
+		[[nodiscard]] size_t Size() const noexcept { return size_; }
+		[[nodiscard]] bool Empty() const noexcept { return size_ == 0; }
+
+		// Bytes reserved by the node pools.
+		[[nodiscard]] size_t MemoryUsage() const noexcept
+		{
+			size_t bytes = 0;
+			for (auto& p : pools_) bytes += p.GetReserved();
+			return bytes;
+		}
+
+		[[nodiscard]] iterator begin() noexcept { return {first_, 0}; }
+		[[nodiscard]] iterator end() noexcept { return {}; }
+		[[nodiscard]] const_iterator begin() const noexcept { return {first_, 0}; }
+		[[nodiscard]] const_iterator end() const noexcept { return {}; }
+
+		void swap(BTreeMap& r) noexcept
+		{
+			using std::swap;
+			swap(pools_, r.pools_);
+			swap(comp_, r.comp_);
+			swap(free_, r.free_);
+			swap(root_, r.root_);
+			swap(first_, r.first_);
+			swap(size_, r.size_);
+		}
+
+	private:
+		template <class T>
+		static void InsertAt(T* a, size_t size, size_t i, T&& x)
+		{
+			if (i == size)
+			{
+				new (a + size) T(std::move(x));
+				return;
+			}
+			new (a + size) T(std::move(a[size - 1]));
+			std::move_backward(a + i, a + size - 1, a + size);
+			a[i] = std::move(x);
+		}
+
+		template <class T>
+		static void EraseAt(T* a, size_t size, size_t i) noexcept
+		{
+			std::move(a + i + 1, a + size, a + i);
+			a[size - 1].~T();
+		}
+
+		// Moves n objects into uninitialized storage and destroys the sources.
+		template <class T>
+		static void MoveRange(T* from, size_t n, T* to) noexcept
+		{
+			for (size_t i=0; i<n; ++i)
+			{
+				new (to + i) T(std::move(from[i]));
+				from[i].~T();
+			}
+		}
+
+		[[nodiscard]] size_t LowerBound(Node* n, const K& key) const noexcept
+		{
+			return std::lower_bound(Keys(n), Keys(n) + n->size, key, comp_) - Keys(n);
+		}
+
+		[[nodiscard]] size_t UpperBound(Node* n, const K& key) const noexcept
+		{
+			return std::upper_bound(Keys(n), Keys(n) + n->size, key, comp_) - Keys(n);
+		}
+
+		[[nodiscard]] iterator LowerBoundImpl(const K& key) const noexcept
+		{
+			if (!root_) return {};
+			auto* n = root_;
+			while (!n->leaf) n = Children(n)[UpperBound(n, key)];
+			const auto i = LowerBound(n, key);
+			if (i == n->size) return {n->next, 0};
+			return {n, i};
+		}
+
+		[[nodiscard]] iterator FindImpl(const K& key) const noexcept
+		{
+			const auto it = LowerBoundImpl(key);
+			if (it.leaf_ && !comp_(key, it.Key())) return it;
+			return {};
+		}
+
+		// Inserts separator key and its right child into the ancestors, splitting full nodes upwards.
+		void InsertUp(Node** path, size_t* slots, size_t depth, K key, Node* child)
+		{
+			while (depth)
+			{
+				--depth;
+				auto* const n = path[depth];
+				const auto slot = slots[depth];
+				if (n->size < kInnerCapacity)
+				{
+					InsertAt(Keys(n), n->size, slot, std::move(key));
+					InsertAt(Children(n), n->size + 1, slot + 1, std::move(child));
+					++n->size;
+					return;
+				}
+
+				constexpr auto mid = kInnerCapacity / 2;
+				auto* const right = NewNode(false);
+				K median{std::move(Keys(n)[mid])};
+				Keys(n)[mid].~K();
+				MoveRange(Keys(n) + mid + 1, kInnerCapacity - mid - 1, Keys(right));
+				std::copy_n(Children(n) + mid + 1, kInnerCapacity - mid, Children(right));
+				n->size = mid;
+				right->size = kInnerCapacity - mid - 1;
+
+				auto* const target = slot <= mid ? n : right;
+				const auto at = slot <= mid ? slot : slot - mid - 1;
+				InsertAt(Keys(target), target->size, at, std::move(key));
+				InsertAt(Children(target), target->size + 1, at + 1, std::move(child));
+				++target->size;
+
+				key = std::move(median);
+				child = right;
+			}
+
+			auto* const root = NewNode(false);
+			new (Keys(root)) K(std::move(key));
+			Children(root)[0] = root_;
+			Children(root)[1] = child;
+			root->size = 1;
+			root_ = root;
+		}
+
+		// Fixes the underflowing child at slot of parent by borrowing from or merging with a sibling.
+		// Returns the parent, which may underflow in turn. Only copying a leaf's new separator can
+		// throw, so that is done before anything moves.
+		Node* Rebalance(Node* parent, size_t slot)
+		{
+			auto* const n = Children(parent)[slot];
+			auto* const left = slot > 0 ? Children(parent)[slot - 1] : nullptr;
+			auto* const right = slot < parent->size ? Children(parent)[slot + 1] : nullptr;
+			const auto min = n->leaf ? kLeafMin : kInnerMin;
+
+			if (left && left->size > min)
+			{
+				if (n->leaf)
+				{
+					Keys(parent)[slot - 1] = Keys(left)[left->size - 1];
+					InsertAt(Keys(n), n->size, 0, std::move(Keys(left)[left->size - 1]));
+					InsertAt(Values(n), n->size, 0, std::move(Values(left)[left->size - 1]));
+					Keys(left)[left->size - 1].~K();
+					Values(left)[left->size - 1].~V();
+				}
+				else
+				{
+					InsertAt(Keys(n), n->size, 0, std::move(Keys(parent)[slot - 1]));
+					InsertAt(Children(n), n->size + 1, 0, std::move(Children(left)[left->size]));
+					Keys(parent)[slot - 1] = std::move(Keys(left)[left->size - 1]);
+					Keys(left)[left->size - 1].~K();
+				}
+				--left->size;
+				++n->size;
+				return parent;
+			}
+
+			if (right && right->size > min)
+			{
+				if (n->leaf)
+				{
+					Keys(parent)[slot] = Keys(right)[1];
+					new (Keys(n) + n->size) K(std::move(Keys(right)[0]));
+					new (Values(n) + n->size) V(std::move(Values(right)[0]));
+					EraseAt(Keys(right), right->size, 0);
+					EraseAt(Values(right), right->size, 0);
+				}
+				else
+				{
+					new (Keys(n) + n->size) K(std::move(Keys(parent)[slot]));
+					Children(n)[n->size + 1] = Children(right)[0];
+					Keys(parent)[slot] = std::move(Keys(right)[0]);
+					EraseAt(Keys(right), right->size, 0);
+					EraseAt(Children(right), right->size + 1, 0);
+				}
+				--right->size;
+				++n->size;
+				return parent;
+			}
+
+			if (left) Merge(parent, slot - 1);
+			else Merge(parent, slot);
+			return parent;
+		}
+
+		// Merges the child at slot + 1 into the child at slot.
+		void Merge(Node* parent, size_t slot) noexcept
+		{
+			auto* const l = Children(parent)[slot];
+			auto* const r = Children(parent)[slot + 1];
+			if (l->leaf)
+			{
+				MoveRange(Keys(r), r->size, Keys(l) + l->size);
+				MoveRange(Values(r), r->size, Values(l) + l->size);
+				l->size += r->size;
+				l->next = r->next;
+			}
+			else
+			{
+				new (Keys(l) + l->size) K(std::move(Keys(parent)[slot]));
+				MoveRange(Keys(r), r->size, Keys(l) + l->size + 1);
+				std::copy_n(Children(r), r->size + 1, Children(l) + l->size + 1);
+				l->size += r->size + 1;
+			}
+			r->size = 0;
+			FreeNode(r);
+			EraseAt(Keys(parent), parent->size, slot);
+			EraseAt(Children(parent), parent->size + 1, slot + 1);
+			--parent->size;
+		}
+
+		void Destroy(Node* n) noexcept
+		{
+			if (n->leaf)
+			{
+				std::destroy_n(Values(n), n->size);
+			}
+			else
+			{
+				for (size_t i=0; i<=n->size; ++i) Destroy(Children(n)[i]);
+			}
+			std::destroy_n(Keys(n), n->size);
+			FreeNode(n);
+		}
+
+		// Reuses a freed node, then draws from the pools.
+		[[nodiscard]] Node* NewNode(bool leaf)
+		{
+			void* p = free_;
+			if (p) free_ = free_->next;
+			else p = AllocNode();
+			return new (p) Node{0, leaf, nullptr};
+		}
+
+		// Draws from the newest pool, adding one twice as large when it runs out. The first pool only
+		// spans a page so that small maps stay small.
+		[[nodiscard]] void* AllocNode()
+		{
+			void* p = pools_.empty() ? nullptr : pools_.back().TryAlloc();
+			if (!p)
+			{
+				const auto count = pools_.empty()
+					? std::max<size_t>(kFirstPoolBytes / NodeBytes, 1)
+					: pools_.back().GetInfo().count * 2;
+				pools_.emplace_back(NodeBytes, count);
+				p = pools_.back().TryAlloc();
+				if (!p) detail::ThrowBadAlloc();
+			}
+			return p;
+		}
+
+		// Makes sure the free list holds at least n nodes, so that a split can't fail halfway.
+		void ReserveNodes(size_t n)
+		{
+			for (auto* f = free_; f && n; f = f->next) --n;
+			for (; n; --n) FreeNode(new (AllocNode()) Node{0, true, nullptr});
+		}
+
+		// Pools are only released with the map, so a freed node is just chained for reuse.
+		void FreeNode(Node* n) noexcept
+		{
+			n->next = free_;
+			free_ = n;
+		}
+
+		std::vector<MemoryPool> pools_;
+		Compare comp_;
+		Node* free_ = nullptr;
+		Node* root_ = nullptr;
+		Node* first_ = nullptr;
+		size_t size_ = 0;
+	};
+}
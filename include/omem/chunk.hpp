@@ -0,0 +1,172 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <omem.hpp>
+
+#if OMEM_HAS_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace omem
+{
+	enum class PageMode
+	{
+		kNormal,
+		kTransparentHuge,
+		kHugeTlb
+	};
+
+	[[nodiscard]] inline size_t PageSize() noexcept
+	{
+#if OMEM_HAS_POSIX
+		static const auto size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		return size;
+#else
+		return 4096;
+#endif
+	}
+
+	constexpr size_t kHugePageSize = size_t(2) << 20;
+
+#if OMEM_HAS_POSIX
+
+	// Anonymous private mappings. Sizes are rounded up to the page (or huge page) size.
+	class MmapChunkProvider
+	{
+	public:
+		MmapChunkProvider()
+			:mode_{GetConfig().huge_pages ? PageMode::kTransparentHuge : PageMode::kNormal}
+		{
+		}
+
+		constexpr MmapChunkProvider(PageMode mode) noexcept
+			:mode_{mode}
+		{
+		}
+
+		[[nodiscard]] void* Allocate(size_t size)
+		{
+			auto flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_HUGETLB
+			if (mode_ == PageMode::kHugeTlb) flags |= MAP_HUGETLB;
+#endif
+			auto* const p = mmap(nullptr, Round(size), PROT_READ | PROT_WRITE, flags, -1, 0);
+			if (p == MAP_FAILED) return detail::AllocFailed();
+#ifdef MADV_HUGEPAGE
+			if (mode_ == PageMode::kTransparentHuge) madvise(p, Round(size), MADV_HUGEPAGE);
+#endif
+			return p;
+		}
+
+		void Deallocate(void* p, size_t size) noexcept
+		{
+			munmap(p, Round(size));
+		}
+
+#ifdef MREMAP_MAYMOVE
+		// Lets the kernel move the pages instead of copying them.
+		[[nodiscard]] void* Reallocate(void* p, size_t old_size, size_t new_size)
+		{
+			auto* const ret = mremap(p, Round(old_size), Round(new_size), MREMAP_MAYMOVE);
+			if (ret == MAP_FAILED) return detail::AllocFailed();
+			return ret;
+		}
+#endif
+
+		[[nodiscard]] PageMode GetMode() const noexcept { return mode_; }
+
+	private:
+		[[nodiscard]] size_t Round(size_t size) const noexcept
+		{
+			const auto page = mode_ == PageMode::kNormal ? PageSize() : kHugePageSize;
+			return (size + page - 1) / page * page;
+		}
+
+		PageMode mode_;
+	};
+
+	// Maps successive ranges of a file descriptor with MAP_SHARED, growing the file as needed.
+	// Works with regular files, shm_open() and memfd_create() descriptors. Released ranges are
+	// unmapped but their file space is not reused. The descriptor is not owned, and offset must be
+	// a multiple of the page size or every allocation fails.
+	class FileChunkResource final : public ChunkResource
+	{
+	public:
+		explicit FileChunkResource(int fd, off_t offset = 0) noexcept
+			:fd_{fd}, offset_{offset}
+		{
+		}
+
+		[[nodiscard]] void* Allocate(size_t size) override
+		{
+			size = Round(size);
+			std::lock_guard<std::mutex> lock{mutex_};
+			if (offset_ < 0 || static_cast<size_t>(offset_) % PageSize() != 0) return detail::AllocFailed();
+			if (ftruncate(fd_, offset_ + static_cast<off_t>(size)) != 0) return detail::AllocFailed();
+			auto* const p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, offset_);
+			if (p == MAP_FAILED) return detail::AllocFailed();
+			offset_ += static_cast<off_t>(size);
+			return p;
+		}
+
+		void Deallocate(void* p, size_t size) noexcept override
+		{
+			munmap(p, Round(size));
+		}
+
+		[[nodiscard]] int GetFd() const noexcept { return fd_; }
+
+	private:
+		[[nodiscard]] static size_t Round(size_t size) noexcept
+		{
+			return (size + PageSize() - 1) / PageSize() * PageSize();
+		}
+
+		std::mutex mutex_;
+		int fd_;
+		off_t offset_;
+	};
+
+#endif
+
+	// Carves chunks out of a caller-supplied memory region, e.g. a block of a parent arena
+	// or a device-mapped range. Memory is only reclaimed when the most recent chunk is freed.
+	class RegionChunkResource final : public ChunkResource
+	{
+	public:
+		RegionChunkResource(void* base, size_t size) noexcept
+			:base_{static_cast<char*>(base)}, size_{size}, used_{0}
+		{
+		}
+
+		[[nodiscard]] void* Allocate(size_t size) override
+		{
+			constexpr auto align = alignof(std::max_align_t);
+			size = (size + align - 1) / align * align;
+			std::lock_guard<std::mutex> lock{mutex_};
+			if (size > size_ - used_) return detail::AllocFailed();
+			auto* const p = base_ + used_;
+			used_ += size;
+			return p;
+		}
+
+		void Deallocate(void* p, size_t size) noexcept override
+		{
+			constexpr auto align = alignof(std::max_align_t);
+			size = (size + align - 1) / align * align;
+			std::lock_guard<std::mutex> lock{mutex_};
+			if (static_cast<char*>(p) + size == base_ + used_) used_ -= size;
+		}
+
+		[[nodiscard]] size_t GetUsed() const noexcept { return used_; }
+
+	private:
+		std::mutex mutex_;
+		char* base_;
+		size_t size_;
+		size_t used_;
+	};
+}
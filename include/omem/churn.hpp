@@ -0,0 +1,264 @@
+#pragma once
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+#include <omem.hpp>
+
+namespace omem
+{
+	// Names the call site of the allocations made by the calling thread while it is alive. Observer
+	// hooks are inlined into the pools, so return addresses don't identify callers; sites are explicit.
+	class ChurnSite
+	{
+	public:
+		explicit ChurnSite(const char* name) noexcept
+			:prev_{Current()}
+		{
+			Current() = name;
+		}
+
+		~ChurnSite() { Current() = prev_; }
+
+		ChurnSite(const ChurnSite&) = delete;
+		ChurnSite& operator=(const ChurnSite&) = delete;
+
+		[[nodiscard]] static const char*& Current() noexcept
+		{
+			thread_local const char* site = nullptr;
+			return site;
+		}
+
+	private:
+		const char* prev_;
+	};
+
+	enum class ChurnAdvice
+	{
+		kNone,
+		kArena,         // short-lived and freed in LIFO order: bump-allocate and drop at once
+		kObjectPool,    // short-lived, one size: a dedicated BasicMemoryPool skips the class lookup
+		kPoolSize       // faults often: raise pool_size.<size> to suggested_pool_size
+	};
+
+	struct ChurnSiteReport
+	{
+		const char* site;
+		size_t size;
+		uint64_t calls;             // estimated from the samples
+		uint64_t mean_lifetime;     // ReadClock() ticks
+		double short_ratio;
+		double lifo_ratio;
+		double fault_ratio;
+		size_t peak_live;           // estimated from the samples
+		bool single_size;           // the site allocates from one size class only
+		ChurnAdvice advice;
+		uint64_t saved_ops;         // estimated manager allocations and frees, or faults, avoided
+		size_t suggested_pool_size;
+	};
+
+	// Samples allocation lifetimes of the calling thread per site and size class, and turns them into
+	// advice. One in sample allocations is followed until it is freed; a lifetime under short_ticks
+	// counts as short, and a free of the newest live sample counts as LIFO. Lifetimes are measured in
+	// ReadClock() ticks: cycles on x86 (20000 is a few microseconds), nanoseconds elsewhere.
+	// The hooks never throw; a sample that can't be recorded for lack of memory is dropped.
+	class ChurnProfile
+	{
+		struct Key
+		{
+			const char* site;
+			size_t size;
+
+			bool operator==(const Key& r) const noexcept { return site == r.site && size == r.size; }
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& k) const noexcept
+			{
+				return std::hash<const void*>{}(k.site) ^ (k.size * 0x9E3779B97F4A7C15ull);
+			}
+		};
+
+		struct Stats
+		{
+			uint64_t samples = 0;
+			uint64_t faults = 0;
+			uint64_t freed = 0;
+			uint64_t lifetime = 0;
+			uint64_t short_lived = 0;
+			uint64_t lifo = 0;
+			size_t live = 0;
+			size_t peak_live = 0;
+		};
+
+		struct Live
+		{
+			Stats* stats;
+			uint64_t time;
+			uint64_t seq;
+		};
+
+	public:
+		explicit ChurnProfile(unsigned sample = 64, uint64_t short_ticks = 20000, size_t max_live = 1 << 16)
+			:sample_{sample}, countdown_{sample}, short_ticks_{short_ticks}, max_live_{max_live}
+		{
+			assert(sample > 0);
+		}
+
+		ChurnProfile(ChurnProfile&&) = default;
+		ChurnProfile& operator=(ChurnProfile&&) = default;
+
+		void OnAlloc(const PoolInfo& info, void* p, bool fault) noexcept
+		{
+			if (--countdown_ != 0) return;
+			countdown_ = sample_;
+			if (live_.size() >= max_live_) return;
+
+			OMEM_TRY
+			{
+				// An entry left with no samples by a later failure is skipped by Report().
+				auto& s = stats_[{ChurnSite::Current(), info.size}];
+				const auto it = live_.insert_or_assign(p, Live{&s, ReadClock(), seq_ + 1}).first;
+				OMEM_TRY { stack_.emplace_back(p, seq_ + 1); }
+				OMEM_CATCH
+				{
+					live_.erase(it);
+					OMEM_RETHROW;
+				}
+				++seq_;
+				++s.samples;
+				s.faults += fault;
+				s.peak_live = std::max(s.peak_live, ++s.live);
+			}
+			OMEM_CATCH {}
+		}
+
+		void OnFree(void* p) noexcept
+		{
+			if (live_.empty()) return;
+			const auto it = live_.find(p);
+			if (it == live_.end()) return;
+
+			auto& s = *it->second.stats;
+			const auto lifetime = ReadClock() - it->second.time;
+			++s.freed;
+			--s.live;
+			s.lifetime += lifetime;
+			s.short_lived += lifetime < short_ticks_;
+			s.lifo += stack_.back().second == it->second.seq;
+			live_.erase(it);
+
+			// Drop freed samples from the top so that back() is the newest live one, and the ones
+			// below it once they outnumber the live samples, which FIFO frees would otherwise pile up.
+			while (!stack_.empty() && !IsLive(stack_.back())) stack_.pop_back();
+			if (stack_.size() > 2 * live_.size() + 64)
+				stack_.erase(std::remove_if(stack_.begin(), stack_.end(), [&](auto& e) { return !IsLive(e); }), stack_.end());
+		}
+
+		[[nodiscard]] size_t StackSize() const noexcept { return stack_.size(); }
+
+		// Sites sorted by estimated calls, most first.
+		[[nodiscard]] std::vector<ChurnSiteReport> Report() const
+		{
+			std::unordered_map<const char*, size_t> sizes;
+			for (auto& [key, s] : stats_) sizes[key.site] += s.samples != 0;
+
+			std::vector<ChurnSiteReport> report;
+			for (auto& [key, s] : stats_)
+			{
+				if (!s.samples) continue;
+				ChurnSiteReport r{};
+				r.site = key.site;
+				r.size = key.size;
+				r.calls = s.samples * sample_;
+				r.mean_lifetime = s.freed ? s.lifetime / s.freed : 0;
+				r.short_ratio = s.freed ? double(s.short_lived) / s.freed : 0;
+				r.lifo_ratio = s.freed ? double(s.lifo) / s.freed : 0;
+				r.fault_ratio = double(s.faults) / s.samples;
+				r.peak_live = s.peak_live * sample_;
+				r.single_size = sizes[key.site] == 1;
+
+				if (r.short_ratio >= 0.5 && r.lifo_ratio >= 0.5)
+				{
+					r.advice = ChurnAdvice::kArena;
+					r.saved_ops = 2 * r.calls;
+				}
+				else if (r.short_ratio >= 0.5 && r.single_size)
+				{
+					r.advice = ChurnAdvice::kObjectPool;
+					r.saved_ops = 2 * r.calls;
+				}
+				else if (r.fault_ratio >= 0.1)
+				{
+					r.advice = ChurnAdvice::kPoolSize;
+					r.saved_ops = s.faults * sample_;
+					r.suggested_pool_size = size_t(1) << LogCeil(r.peak_live * r.size, 2);
+				}
+				report.push_back(r);
+			}
+			std::sort(report.begin(), report.end(), [](auto& a, auto& b) { return a.calls > b.calls; });
+			return report;
+		}
+
+		void Write(std::FILE* out) const
+		{
+			static const char* const kAdvice[] = {"-", "arena", "object pool", "pool_size"};
+			std::fprintf(out, "%-32s %8s %12s %12s %7s %7s %7s  %s\n",
+				"site", "size", "calls", "lifetime", "short", "lifo", "fault", "advice");
+			for (auto& r : Report())
+			{
+				std::fprintf(out, "%-32s %8zu %12llu %12llu %6.1f%% %6.1f%% %6.1f%%  %s",
+					r.site ? r.site : "(unnamed)", r.size, static_cast<unsigned long long>(r.calls),
+					static_cast<unsigned long long>(r.mean_lifetime), r.short_ratio * 100, r.lifo_ratio * 100,
+					r.fault_ratio * 100, kAdvice[static_cast<int>(r.advice)]);
+				if (r.advice == ChurnAdvice::kPoolSize)
+					std::fprintf(out, " %zu, ~%llu faults saved", r.suggested_pool_size, static_cast<unsigned long long>(r.saved_ops));
+				else if (r.advice != ChurnAdvice::kNone)
+					std::fprintf(out, ", ~%llu manager calls saved", static_cast<unsigned long long>(r.saved_ops));
+				std::fputc('\n', out);
+			}
+		}
+
+		void Reset()
+		{
+			stats_.clear();
+			live_.clear();
+			stack_.clear();
+			countdown_ = sample_;
+		}
+
+	private:
+		[[nodiscard]] bool IsLive(const std::pair<void*, uint64_t>& e) const noexcept
+		{
+			const auto it = live_.find(e.first);
+			return it != live_.end() && it->second.seq == e.second;
+		}
+
+		unsigned sample_;
+		unsigned countdown_;
+		uint64_t short_ticks_;
+		size_t max_live_;
+		uint64_t seq_ = 0;
+		std::unordered_map<Key, Stats, KeyHash> stats_;
+		std::unordered_map<void*, Live> live_;
+		std::vector<std::pair<void*, uint64_t>> stack_;
+	};
+
+	// Feeds the calling thread's ChurnProfile. Pair it with ChurnSite scopes around the code studied.
+	class ChurnObserver
+	{
+	public:
+		[[nodiscard]] static ChurnProfile& ThreadProfile()
+		{
+			thread_local ChurnProfile profile;
+			return profile;
+		}
+
+		void OnAlloc(const PoolInfo& info, void* p) noexcept { ThreadProfile().OnAlloc(info, p, false); }
+		void OnFree(const PoolInfo&, void* p) noexcept { ThreadProfile().OnFree(p); }
+		void OnFault(const PoolInfo& info, void* p) noexcept { ThreadProfile().OnAlloc(info, p, true); }
+		void OnGrow(const PoolInfo&, void*, size_t) noexcept {}
+		void OnTrim(const PoolInfo&, void*, size_t) noexcept {}
+	};
+}
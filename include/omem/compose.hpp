@@ -0,0 +1,334 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <omem.hpp>
+
+// Allocator building blocks. Every block exposes
+//   void* Alloc(size_t size)        - nullptr when it can't serve the request
+//   void Free(void* p, size_t size)
+//   bool Owns(const void* p) const  - only needed when composed by FallbackAllocator
+// MemoryPoolManager and NewAllocator throw std::bad_alloc instead of returning nullptr, so a
+// FallbackAllocator can't move past them; wrap the manager in NothrowAllocator to use it as a leaf.
+
+namespace omem
+{
+	template <class T>
+	[[nodiscard]] constexpr T AlignUp(T x, size_t align) noexcept
+	{
+		return (x + align - 1) / align * align;
+	}
+
+	class NewAllocator
+	{
+	public:
+		[[nodiscard]] void* Alloc(size_t size) { return operator new(size); }
+		void Free(void* p, size_t) noexcept { operator delete(p); }
+	};
+
+	class NullAllocator
+	{
+	public:
+		[[nodiscard]] void* Alloc(size_t) noexcept { return nullptr; }
+		void Free(void* p, size_t) noexcept { assert(!p); }
+		[[nodiscard]] bool Owns(const void* p) const noexcept { return !p; }
+	};
+
+	class PoolAllocator
+	{
+	public:
+		PoolAllocator(size_t size, size_t count)
+			:pool_{size, count}
+		{
+		}
+
+		[[nodiscard]] void* Alloc(size_t size) noexcept
+		{
+			return size <= pool_.GetInfo().size ? pool_.TryAlloc() : nullptr;
+		}
+
+		void Free(void* p, size_t) noexcept { pool_.Free(p); }
+		[[nodiscard]] bool Owns(const void* p) const noexcept { return pool_.Owns(p); }
+		[[nodiscard]] const PoolInfo& GetInfo() const noexcept { return pool_.GetInfo(); }
+
+	private:
+		MemoryPool pool_;
+	};
+
+	template <size_t Threshold, class Small, class Large>
+	class Segregator
+	{
+	public:
+		Segregator() = default;
+
+		Segregator(Small small, Large large)
+			:small_{std::move(small)}, large_{std::move(large)}
+		{
+		}
+
+		[[nodiscard]] void* Alloc(size_t size)
+		{
+			return size <= Threshold ? small_.Alloc(size) : large_.Alloc(size);
+		}
+
+		void Free(void* p, size_t size) noexcept
+		{
+			if (size <= Threshold) small_.Free(p, size);
+			else large_.Free(p, size);
+		}
+
+		[[nodiscard]] bool Owns(const void* p) const noexcept
+		{
+			return small_.Owns(p) || large_.Owns(p);
+		}
+
+		[[nodiscard]] Small& GetSmall() noexcept { return small_; }
+		[[nodiscard]] Large& GetLarge() noexcept { return large_; }
+
+	private:
+		Small small_;
+		Large large_;
+	};
+
+	// Adapts a block whose Alloc throws but which has an Alloc(size, std::nothrow) overload, such as
+	// MemoryPoolManager, to the nullptr-on-failure contract.
+	template <class A = MemoryPoolManager>
+	class NothrowAllocator
+	{
+	public:
+		NothrowAllocator() = default;
+
+		explicit NothrowAllocator(A parent)
+			:parent_{std::move(parent)}
+		{
+		}
+
+		[[nodiscard]] void* Alloc(size_t size) noexcept { return parent_.Alloc(size, std::nothrow); }
+		void Free(void* p, size_t size) noexcept { parent_.Free(p, size); }
+		[[nodiscard]] bool Owns(const void* p) const noexcept { return parent_.Owns(p); }
+		[[nodiscard]] A& GetParent() noexcept { return parent_; }
+
+	private:
+		A parent_;
+	};
+
+	template <class Primary, class Secondary>
+	class FallbackAllocator
+	{
+	public:
+		FallbackAllocator() = default;
+
+		FallbackAllocator(Primary primary, Secondary secondary)
+			:primary_{std::move(primary)}, secondary_{std::move(secondary)}
+		{
+		}
+
+		[[nodiscard]] void* Alloc(size_t size)
+		{
+			if (auto* const p = primary_.Alloc(size)) return p;
+			return secondary_.Alloc(size);
+		}
+
+		void Free(void* p, size_t size) noexcept
+		{
+			if (primary_.Owns(p)) primary_.Free(p, size);
+			else secondary_.Free(p, size);
+		}
+
+		[[nodiscard]] bool Owns(const void* p) const noexcept
+		{
+			return primary_.Owns(p) || secondary_.Owns(p);
+		}
+
+		[[nodiscard]] Primary& GetPrimary() noexcept { return primary_; }
+		[[nodiscard]] Secondary& GetSecondary() noexcept { return secondary_; }
+
+	private:
+		Primary primary_;
+		Secondary secondary_;
+	};
+
+	// Buckets cover (Min, Min+Step], (Min+Step, Min+2*Step], ... up to Max.
+	// Each bucket is constructed as A(bucket_size, args...); sizes outside the range are refused.
+	template <class A, size_t Min, size_t Max, size_t Step>
+	class Bucketizer
+	{
+		static_assert(Step > 0 && Min < Max && (Max - Min) % Step == 0);
+		static constexpr size_t kCount = (Max - Min) / Step;
+
+	public:
+		template <class... Args>
+		explicit Bucketizer(const Args&... args)
+			:buckets_{Make(std::make_index_sequence<kCount>{}, args...)}
+		{
+		}
+
+		[[nodiscard]] void* Alloc(size_t size)
+		{
+			if (size <= Min || size > Max) return nullptr;
+			return buckets_[Index(size)].Alloc(size);
+		}
+
+		void Free(void* p, size_t size) noexcept
+		{
+			buckets_[Index(size)].Free(p, size);
+		}
+
+		[[nodiscard]] bool Owns(const void* p) const noexcept
+		{
+			for (auto& b : buckets_) if (b.Owns(p)) return true;
+			return false;
+		}
+
+		[[nodiscard]] A& GetBucket(size_t size) noexcept { return buckets_[Index(size)]; }
+		[[nodiscard]] static constexpr size_t BucketCount() noexcept { return kCount; }
+
+	private:
+		[[nodiscard]] static constexpr size_t Index(size_t size) noexcept
+		{
+			assert(size > Min && size <= Max);
+			return (size - Min - 1) / Step;
+		}
+
+		template <size_t... I, class... Args>
+		[[nodiscard]] static std::array<A, kCount> Make(std::index_sequence<I...>, const Args&... args)
+		{
+			return {A(Min + (I+1)*Step, args...)...};
+		}
+
+		std::array<A, kCount> buckets_;
+	};
+
+	struct AllocStats
+	{
+		size_t alloc = 0;
+		size_t free = 0;
+		size_t failed = 0;
+		size_t bytes = 0;
+		size_t peak_bytes = 0;
+	};
+
+	template <class A>
+	class StatsCollector
+	{
+	public:
+		StatsCollector() = default;
+
+		explicit StatsCollector(A parent)
+			:parent_{std::move(parent)}
+		{
+		}
+
+		[[nodiscard]] void* Alloc(size_t size)
+		{
+			auto* const p = parent_.Alloc(size);
+			if (!p)
+			{
+				++stats_.failed;
+				return nullptr;
+			}
+			++stats_.alloc;
+			stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.bytes += size);
+			return p;
+		}
+
+		void Free(void* p, size_t size) noexcept
+		{
+			if (!p) return;
+			++stats_.free;
+			stats_.bytes -= size;
+			parent_.Free(p, size);
+		}
+
+		[[nodiscard]] bool Owns(const void* p) const noexcept { return parent_.Owns(p); }
+		[[nodiscard]] const AllocStats& GetStats() const noexcept { return stats_; }
+		[[nodiscard]] A& GetParent() noexcept { return parent_; }
+
+	private:
+		A parent_;
+		AllocStats stats_;
+	};
+
+	namespace detail
+	{
+		template <class T>
+		struct AffixTraits
+		{
+			static constexpr size_t size = sizeof(T), align = alignof(T);
+		};
+
+		template <>
+		struct AffixTraits<void>
+		{
+			static constexpr size_t size = 0, align = 1;
+		};
+	}
+
+	// Places a Prefix object before and an optional Suffix object after every block.
+	// The prefix slot is padded to max_align_t so that user blocks keep the parent's alignment.
+	template <class A, class Prefix, class Suffix = void>
+	class AffixAllocator
+	{
+		static constexpr size_t kPrefixSize = AlignUp(sizeof(Prefix), alignof(std::max_align_t));
+
+		using Traits = detail::AffixTraits<Suffix>;
+
+	public:
+		AffixAllocator() = default;
+
+		explicit AffixAllocator(A parent)
+			:parent_{std::move(parent)}
+		{
+		}
+
+		[[nodiscard]] void* Alloc(size_t size)
+		{
+			auto* const raw = static_cast<char*>(parent_.Alloc(Total(size)));
+			if (!raw) return nullptr;
+			new (raw) Prefix{};
+			if constexpr (Traits::size > 0) new (raw + SuffixOffset(size)) Suffix{};
+			return raw + kPrefixSize;
+		}
+
+		void Free(void* p, size_t size) noexcept
+		{
+			if (!p) return;
+			auto* const raw = static_cast<char*>(p) - kPrefixSize;
+			if constexpr (Traits::size > 0) GetSuffix(p, size).~Suffix();
+			GetPrefix(p).~Prefix();
+			parent_.Free(raw, Total(size));
+		}
+
+		[[nodiscard]] bool Owns(const void* p) const noexcept
+		{
+			return parent_.Owns(static_cast<const char*>(p) - kPrefixSize);
+		}
+
+		[[nodiscard]] static Prefix& GetPrefix(void* p) noexcept
+		{
+			return *std::launder(reinterpret_cast<Prefix*>(static_cast<char*>(p) - kPrefixSize));
+		}
+
+		template <class S = Suffix>
+		[[nodiscard]] static S& GetSuffix(void* p, size_t size) noexcept
+		{
+			auto* const raw = static_cast<char*>(p) - kPrefixSize;
+			return *std::launder(reinterpret_cast<S*>(raw + SuffixOffset(size)));
+		}
+
+		[[nodiscard]] A& GetParent() noexcept { return parent_; }
+
+	private:
+		[[nodiscard]] static constexpr size_t SuffixOffset(size_t size) noexcept
+		{
+			return AlignUp(kPrefixSize + size, Traits::align);
+		}
+
+		[[nodiscard]] static constexpr size_t Total(size_t size) noexcept
+		{
+			return SuffixOffset(size) + Traits::size;
+		}
+
+		A parent_;
+	};
+}
@@ -0,0 +1,243 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include <omem/chunk.hpp>
+
+// Code pages are built from mmap(), mprotect() and memfd, so ExecutablePool is only available on POSIX systems.
+#if OMEM_HAS_POSIX
+namespace omem
+{
+	enum class ExecMode
+	{
+		kDualMap,
+		kMprotect
+	};
+
+	// A block of code memory. Write through write, call through exec; they alias the same bytes.
+	struct CodeBlock
+	{
+		template <class F>
+		[[nodiscard]] F* As() const noexcept { return reinterpret_cast<F*>(const_cast<void*>(exec)); }
+
+		void* write;
+		const void* exec;
+		size_t size;
+	};
+
+	// Packs JIT code fragments into shared pages by power-of-two size class (16 B to 4 KiB) without
+	// ever having a page writable and executable at once. kDualMap maps every chunk of a memfd twice,
+	// RW and RX, so code is written and run without changing protections. kMprotect, used when memfd
+	// is unavailable, keeps one view and switches all chunks written since the last Seal() to RX in
+	// one pass; allocating from a sealed chunk makes it writable (and not executable) again.
+	// Free lists are kept outside the code pages. Not thread-safe.
+	class ExecutablePool
+	{
+		static constexpr size_t kMinLog = 4;
+		static constexpr size_t kMaxLog = 12;
+
+		struct Chunk
+		{
+			char* write;
+			char* exec;
+			size_t size;
+			off_t offset;
+			bool writable;
+		};
+
+		struct FreeBlock
+		{
+			char* exec;
+			size_t chunk;
+		};
+
+	public:
+		explicit ExecutablePool(ExecMode mode = ExecMode::kDualMap, size_t chunk_size = 256 << 10)
+			:chunk_size_{RoundPage(chunk_size)}, mode_{mode}
+		{
+#ifdef MFD_CLOEXEC
+			if (mode_ == ExecMode::kDualMap) fd_ = memfd_create("omem-exec", MFD_CLOEXEC);
+#endif
+			if (fd_ < 0) mode_ = ExecMode::kMprotect;
+		}
+
+		~ExecutablePool()
+		{
+			for (auto& c : chunks_) Unmap(c);
+			if (fd_ >= 0) close(fd_);
+		}
+
+		ExecutablePool(const ExecutablePool&) = delete;
+		ExecutablePool& operator=(const ExecutablePool&) = delete;
+
+		[[nodiscard]] CodeBlock Alloc(size_t size)
+		{
+			const auto log = std::max(LogCeil(size, 2), kMinLog);
+			if (log > kMaxLog)
+			{
+				const auto idx = NewChunk(RoundPage(size));
+				MakeWritable(idx);
+				return {chunks_[idx].write, chunks_[idx].exec, size};
+			}
+
+			const auto block = size_t(1) << log;
+			auto& list = free_[log - kMinLog];
+			FreeBlock b;
+			if (!list.empty())
+			{
+				b = list.back();
+				list.pop_back();
+			}
+			else
+			{
+				// A class's free list never outgrows the blocks carved for it, so Free() never allocates.
+				auto& carved = carved_[log - kMinLog];
+				if (list.capacity() <= carved) list.reserve(std::max(carved + 1, list.capacity() * 2));
+				if (cur_ == kNone || used_ + block > chunks_[cur_].size)
+				{
+					cur_ = NewChunk(chunk_size_);
+					used_ = 0;
+				}
+				b = {chunks_[cur_].exec + used_, cur_};
+				used_ += block;
+				++carved;
+			}
+
+			MakeWritable(b.chunk);
+			auto& c = chunks_[b.chunk];
+			return {c.write + (b.exec - c.exec), b.exec, block};
+		}
+
+		void Free(const CodeBlock& block) noexcept
+		{
+			auto* const exec = static_cast<char*>(const_cast<void*>(block.exec));
+			const auto idx = FindChunk(exec);
+			const auto log = std::max(LogCeil(block.size, 2), kMinLog);
+			if (log > kMaxLog)
+			{
+				Unmap(chunks_[idx]);
+				chunks_[idx] = {};
+				return;
+			}
+			free_[log - kMinLog].push_back({exec, idx});
+		}
+
+		// Makes code written since the last call executable. Must be called before running it.
+		void Seal()
+		{
+			for (auto idx : dirty_)
+			{
+				auto& c = chunks_[idx];
+				if (mode_ == ExecMode::kMprotect)
+				{
+					if (mprotect(c.exec, c.size, PROT_READ | PROT_EXEC) != 0) detail::ThrowBadAlloc();
+					c.writable = false;
+				}
+#if defined(__GNUC__) || defined(__clang__)
+				__builtin___clear_cache(c.exec, c.exec + c.size);
+#endif
+			}
+			dirty_.clear();
+		}
+
+		[[nodiscard]] ExecMode GetMode() const noexcept { return mode_; }
+
+		// Bytes mapped for code. In kDualMap mode each byte is mapped twice but backed once.
+		[[nodiscard]] size_t GetReserved() const noexcept
+		{
+			size_t bytes = 0;
+			for (auto& c : chunks_) bytes += c.size;
+			return bytes;
+		}
+
+	private:
+		static constexpr size_t kNone = ~size_t(0);
+
+		[[nodiscard]] static size_t RoundPage(size_t size) noexcept
+		{
+			return (size + PageSize() - 1) / PageSize() * PageSize();
+		}
+
+		size_t NewChunk(size_t size)
+		{
+			Chunk c{nullptr, nullptr, size, 0, false};
+			if (mode_ == ExecMode::kDualMap)
+			{
+				c.offset = file_size_;
+				if (ftruncate(fd_, file_size_ + static_cast<off_t>(size)) != 0) detail::ThrowBadAlloc();
+				file_size_ += static_cast<off_t>(size);
+				auto* const w = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, c.offset);
+				if (w == MAP_FAILED) detail::ThrowBadAlloc();
+				auto* const x = mmap(nullptr, size, PROT_READ | PROT_EXEC, MAP_SHARED, fd_, c.offset);
+				if (x == MAP_FAILED)
+				{
+					munmap(w, size);
+					detail::ThrowBadAlloc();
+				}
+				c.write = static_cast<char*>(w);
+				c.exec = static_cast<char*>(x);
+				c.writable = true;
+			}
+			else
+			{
+				auto* const p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+				if (p == MAP_FAILED) detail::ThrowBadAlloc();
+				c.write = c.exec = static_cast<char*>(p);
+				c.writable = true;
+			}
+
+			for (size_t i=0; i<chunks_.size(); ++i)
+			{
+				if (!chunks_[i].exec)
+				{
+					chunks_[i] = c;
+					return i;
+				}
+			}
+			chunks_.push_back(c);
+			return chunks_.size() - 1;
+		}
+
+		void MakeWritable(size_t idx)
+		{
+			auto& c = chunks_[idx];
+			if (std::find(dirty_.begin(), dirty_.end(), idx) == dirty_.end()) dirty_.push_back(idx);
+			if (c.writable) return;
+			if (mprotect(c.exec, c.size, PROT_READ | PROT_WRITE) != 0) detail::ThrowBadAlloc();
+			c.writable = true;
+		}
+
+		[[nodiscard]] size_t FindChunk(const char* exec) const noexcept
+		{
+			for (size_t i=0; i<chunks_.size(); ++i)
+			{
+				const auto& c = chunks_[i];
+				if (exec >= c.exec && exec < c.exec + c.size) return i;
+			}
+			assert(!"omem: block not from this ExecutablePool");
+			return kNone;
+		}
+
+		void Unmap(const Chunk& c) noexcept
+		{
+			if (!c.exec) return;
+			munmap(c.exec, c.size);
+			if (c.write != c.exec) munmap(c.write, c.size);
+#ifdef FALLOC_FL_PUNCH_HOLE
+			if (mode_ == ExecMode::kDualMap)
+				fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, c.offset, static_cast<off_t>(c.size));
+#endif
+		}
+
+		std::vector<Chunk> chunks_;
+		std::vector<FreeBlock> free_[kMaxLog - kMinLog + 1];
+		size_t carved_[kMaxLog - kMinLog + 1]{};
+		std::vector<size_t> dirty_;
+		size_t cur_ = kNone;
+		size_t used_ = 0;
+		size_t chunk_size_;
+		off_t file_size_ = 0;
+		int fd_ = -1;
+		ExecMode mode_;
+	};
+}
+#endif
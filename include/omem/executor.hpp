@@ -0,0 +1,420 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <omem.hpp>
+
+namespace omem
+{
+	// Chase-Lev work-stealing deque (Le et al., "Correct and Efficient Work-Stealing for Weak
+	// Memory Models"). Push/Take are owner-only, Steal may be called from any thread.
+	template <class T>
+	class WorkStealingDeque
+	{
+		struct Array
+		{
+			explicit Array(int64_t capacity)
+				:capacity{capacity}, mask{capacity - 1}, slots{new std::atomic<T*>[capacity]}
+			{
+			}
+
+			[[nodiscard]] T* Get(int64_t i) const noexcept { return slots[i & mask].load(std::memory_order_relaxed); }
+			void Put(int64_t i, T* x) noexcept { slots[i & mask].store(x, std::memory_order_relaxed); }
+
+			int64_t capacity;
+			int64_t mask;
+			std::unique_ptr<std::atomic<T*>[]> slots;
+		};
+
+	public:
+		explicit WorkStealingDeque(int64_t capacity = 256)
+		{
+			assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+			arrays_.push_back(std::make_unique<Array>(capacity));
+			array_.store(arrays_.back().get(), std::memory_order_relaxed);
+		}
+
+		void Push(T* x)
+		{
+			const auto b = bottom_.load(std::memory_order_relaxed);
+			const auto t = top_.load(std::memory_order_acquire);
+			auto* a = array_.load(std::memory_order_relaxed);
+			if (b - t > a->capacity - 1) a = Grow(a, t, b);
+			a->Put(b, x);
+			std::atomic_thread_fence(std::memory_order_release);
+			bottom_.store(b + 1, std::memory_order_relaxed);
+		}
+
+		[[nodiscard]] T* Take() noexcept
+		{
+			const auto b = bottom_.load(std::memory_order_relaxed) - 1;
+			auto* const a = array_.load(std::memory_order_relaxed);
+			bottom_.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			auto t = top_.load(std::memory_order_relaxed);
+
+			if (t > b)
+			{
+				bottom_.store(b + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			auto* x = a->Get(b);
+			if (t == b)
+			{
+				if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					x = nullptr;
+				bottom_.store(b + 1, std::memory_order_relaxed);
+			}
+			return x;
+		}
+
+		[[nodiscard]] T* Steal() noexcept
+		{
+			auto t = top_.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const auto b = bottom_.load(std::memory_order_acquire);
+			if (t >= b) return nullptr;
+
+			auto* const x = array_.load(std::memory_order_acquire)->Get(t);
+			if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return nullptr;
+			return x;
+		}
+
+		[[nodiscard]] bool Empty() const noexcept
+		{
+			return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+		}
+
+	private:
+		// Old arrays are kept alive until destruction since thieves may still be reading them.
+		Array* Grow(Array* a, int64_t t, int64_t b)
+		{
+			auto bigger = std::make_unique<Array>(a->capacity * 2);
+			for (auto i = t; i < b; ++i) bigger->Put(i, a->Get(i));
+			arrays_.push_back(std::move(bigger));
+			a = arrays_.back().get();
+			array_.store(a, std::memory_order_release);
+			return a;
+		}
+
+		alignas(64) std::atomic<int64_t> top_{0};
+		alignas(64) std::atomic<int64_t> bottom_{0};
+		std::atomic<Array*> array_;
+		std::vector<std::unique_ptr<Array>> arrays_;
+	};
+
+	class Executor;
+
+	// Runs closures on a pool of workers with one work-stealing deque each. Task frames spawned by a
+	// worker are allocated from that worker's MemoryPoolManager. A frame completed on another
+	// worker is pushed onto its owner's remote-free stack and returned to the pool on the owner's
+	// next spawn or when it runs out of work, so spawning and completing never touch the global
+	// allocator once the pools are warm. Tasks must not throw.
+	class Executor
+	{
+		struct Worker;
+
+		struct TaskFrame
+		{
+			void (*run)(TaskFrame*) noexcept;
+			Worker* owner;
+			size_t size;
+			TaskFrame* next;
+		};
+
+		template <class F>
+		struct TaskFrameImpl : TaskFrame
+		{
+			static void Run(TaskFrame* t) noexcept
+			{
+				auto* const self = static_cast<TaskFrameImpl*>(t);
+				self->fn();
+				self->~TaskFrameImpl();
+			}
+
+			F fn;
+		};
+
+		struct Worker
+		{
+			explicit Worker(Executor& executor)
+				:executor{executor}, rng{reinterpret_cast<uintptr_t>(this) | 1}
+			{
+			}
+
+			~Worker()
+			{
+				DrainRemote();
+			}
+
+			void DrainRemote() noexcept
+			{
+				if (!remote.load(std::memory_order_relaxed)) return;
+				for (auto* t = remote.exchange(nullptr, std::memory_order_acquire); t;)
+				{
+					auto* const next = t->next;
+					pools.Free(t, t->size);
+					t = next;
+				}
+			}
+
+			Executor& executor;
+			WorkStealingDeque<TaskFrame> deque;
+			MemoryPoolManager pools;
+			alignas(64) std::atomic<TaskFrame*> remote{nullptr};
+			uint64_t rng;
+			std::thread thread;
+		};
+
+	public:
+		explicit Executor(size_t threads = std::thread::hardware_concurrency())
+		{
+			threads = std::max<size_t>(threads, 1);
+			workers_.reserve(threads);
+			for (size_t i=0; i<threads; ++i) workers_.push_back(std::make_unique<Worker>(*this));
+			for (auto& w : workers_) w->thread = std::thread{[this, &w = *w] { Loop(w); }};
+		}
+
+		// Waits for every spawned task to finish.
+		~Executor()
+		{
+			while (pending_.load(std::memory_order_acquire)) std::this_thread::yield();
+			stop_.store(true, std::memory_order_release);
+			cv_.notify_all();
+			for (auto& w : workers_) w->thread.join();
+		}
+
+		Executor(const Executor&) = delete;
+		Executor& operator=(const Executor&) = delete;
+
+		template <class F>
+		void Spawn(F&& f)
+		{
+			using Frame = TaskFrameImpl<std::decay_t<F>>;
+			static_assert(alignof(Frame) <= alignof(std::max_align_t));
+
+			auto* const w = Current();
+			void* p;
+			if (w)
+			{
+				w->DrainRemote();
+				p = w->pools.Alloc(sizeof(Frame));
+			}
+			else
+			{
+				p = operator new(sizeof(Frame));
+			}
+
+			Frame* frame;
+			OMEM_TRY { frame = new (p) Frame{{&Frame::Run, w, sizeof(Frame), nullptr}, std::forward<F>(f)}; }
+			OMEM_CATCH
+			{
+				Release(w, p, sizeof(Frame));
+				OMEM_RETHROW;
+			}
+
+			// Counted before the frame becomes visible, since whoever runs it decrements.
+			pending_.fetch_add(1, std::memory_order_relaxed);
+			OMEM_TRY { Enqueue(w, frame); }
+			OMEM_CATCH
+			{
+				pending_.fetch_sub(1, std::memory_order_relaxed);
+				frame->~Frame();
+				Release(w, frame, sizeof(Frame));
+				OMEM_RETHROW;
+			}
+
+			if (sleepers_.load(std::memory_order_relaxed)) cv_.notify_one();
+		}
+
+		[[nodiscard]] size_t Size() const noexcept { return workers_.size(); }
+
+		// Runs one pending task on the calling worker thread. Returns false if none was found.
+		bool RunOne()
+		{
+			auto* const w = Current();
+			if (!w) return false;
+			auto* const t = Find(*w);
+			if (!t)
+			{
+				w->DrainRemote();
+				return false;
+			}
+			Execute(*w, t);
+			return true;
+		}
+
+	private:
+		[[nodiscard]] Worker* Current() const noexcept
+		{
+			auto* const w = CurrentWorker();
+			return w && &w->executor == this ? w : nullptr;
+		}
+
+		[[nodiscard]] static Worker*& CurrentWorker() noexcept
+		{
+			thread_local Worker* worker = nullptr;
+			return worker;
+		}
+
+		void Enqueue(Worker* w, TaskFrame* frame)
+		{
+			if (w) return w->deque.Push(frame);
+			std::lock_guard<std::mutex> lock{mutex_};
+			injected_.push_back(frame);
+			has_injected_.store(true, std::memory_order_release);
+		}
+
+		static void Release(Worker* w, void* p, size_t size) noexcept
+		{
+			if (w) w->pools.Free(p, size);
+			else operator delete(p);
+		}
+
+		void Loop(Worker& w)
+		{
+			CurrentWorker() = &w;
+			for (size_t idle = 0;;)
+			{
+				if (auto* const t = Find(w))
+				{
+					Execute(w, t);
+					idle = 0;
+					continue;
+				}
+
+				if (stop_.load(std::memory_order_acquire)) break;
+				w.DrainRemote();
+				if (++idle < 64)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock{mutex_};
+				sleepers_.fetch_add(1, std::memory_order_relaxed);
+				cv_.wait_for(lock, std::chrono::milliseconds{1});
+				sleepers_.fetch_sub(1, std::memory_order_relaxed);
+				idle = 0;
+			}
+			w.DrainRemote();
+			CurrentWorker() = nullptr;
+		}
+
+		TaskFrame* Find(Worker& w)
+		{
+			if (auto* const t = w.deque.Take()) return t;
+
+			if (has_injected_.load(std::memory_order_acquire))
+			{
+				std::lock_guard<std::mutex> lock{mutex_};
+				if (!injected_.empty())
+				{
+					auto* const t = injected_.front();
+					injected_.pop_front();
+					has_injected_.store(!injected_.empty(), std::memory_order_relaxed);
+					return t;
+				}
+			}
+
+			const auto n = workers_.size();
+			w.rng ^= w.rng << 13;
+			w.rng ^= w.rng >> 7;
+			w.rng ^= w.rng << 17;
+			const auto start = static_cast<size_t>(w.rng % n);
+			for (size_t i=0; i<n; ++i)
+			{
+				auto& victim = *workers_[(start + i) % n];
+				if (&victim == &w) continue;
+				if (auto* const t = victim.deque.Steal()) return t;
+			}
+			return nullptr;
+		}
+
+		void Execute(Worker& w, TaskFrame* t) noexcept
+		{
+			t->run(t);
+
+			auto* const owner = t->owner;
+			if (owner == &w)
+			{
+				w.pools.Free(t, t->size);
+			}
+			else if (!owner)
+			{
+				Release(nullptr, t, t->size);
+			}
+			else
+			{
+				t->next = owner->remote.load(std::memory_order_relaxed);
+				while (!owner->remote.compare_exchange_weak(t->next, t,
+					std::memory_order_release, std::memory_order_relaxed)) {}
+			}
+
+			pending_.fetch_sub(1, std::memory_order_release);
+		}
+
+		std::vector<std::unique_ptr<Worker>> workers_;
+		std::mutex mutex_;
+		std::condition_variable cv_;
+		std::deque<TaskFrame*> injected_;
+		std::atomic<bool> has_injected_{false};
+		std::atomic<size_t> sleepers_{0};
+		std::atomic<size_t> pending_{0};
+		std::atomic<bool> stop_{false};
+	};
+
+	// Fork/join scope. Wait() executes other tasks while the group is unfinished when called
+	// from a worker thread.
+	class TaskGroup
+	{
+	public:
+		explicit TaskGroup(Executor& executor) noexcept
+			:executor_{executor}
+		{
+		}
+
+		~TaskGroup()
+		{
+			Wait();
+		}
+
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup& operator=(const TaskGroup&) = delete;
+
+		template <class F>
+		void Run(F&& f)
+		{
+			pending_.fetch_add(1, std::memory_order_relaxed);
+			OMEM_TRY
+			{
+				executor_.Spawn([this, f = std::forward<F>(f)]() mutable
+				{
+					f();
+					pending_.fetch_sub(1, std::memory_order_release);
+				});
+			}
+			OMEM_CATCH
+			{
+				pending_.fetch_sub(1, std::memory_order_relaxed);
+				OMEM_RETHROW;
+			}
+		}
+
+		void Wait()
+		{
+			while (pending_.load(std::memory_order_acquire))
+				if (!executor_.RunOne()) std::this_thread::yield();
+		}
+
+	private:
+		Executor& executor_;
+		std::atomic<size_t> pending_{0};
+	};
+}
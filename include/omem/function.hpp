@@ -0,0 +1,148 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <omem.hpp>
+
+namespace omem
+{
+	template <class Sig, size_t InlineSize = 4 * sizeof(void*)>
+	class Function;
+
+	// Move-only std::function replacement. Callables that fit in InlineSize bytes and are nothrow
+	// movable are stored inline; larger ones spill into ThreadPools(), so a Function holding a
+	// spilled callable must be destroyed on the thread that created it.
+	template <class R, class... Args, size_t InlineSize>
+	class Function<R(Args...), InlineSize>
+	{
+		static constexpr size_t kBufSize = std::max(InlineSize, sizeof(void*));
+
+		struct VTable
+		{
+			R (*invoke)(void* buf, Args&&... args);
+			void (*move)(void* dst, void* src) noexcept;
+			void (*destroy)(void* buf) noexcept;
+		};
+
+		template <class F>
+		static constexpr bool kIsInline = sizeof(F) <= kBufSize
+			&& alignof(F) <= alignof(std::max_align_t)
+			&& std::is_nothrow_move_constructible_v<F>;
+
+		template <class F>
+		struct Inline
+		{
+			static F* Get(void* buf) noexcept { return std::launder(static_cast<F*>(buf)); }
+			static R Invoke(void* buf, Args&&... args) { return (*Get(buf))(std::forward<Args>(args)...); }
+
+			static void Move(void* dst, void* src) noexcept
+			{
+				new (dst) F{std::move(*Get(src))};
+				Get(src)->~F();
+			}
+
+			static void Destroy(void* buf) noexcept { Get(buf)->~F(); }
+
+			static constexpr VTable vtable{&Invoke, &Move, &Destroy};
+		};
+
+		template <class F>
+		struct Spilled
+		{
+			static F*& Get(void* buf) noexcept { return *std::launder(static_cast<F**>(buf)); }
+			static R Invoke(void* buf, Args&&... args) { return (*Get(buf))(std::forward<Args>(args)...); }
+			static void Move(void* dst, void* src) noexcept { new (dst) F*{Get(src)}; }
+
+			static void Destroy(void* buf) noexcept
+			{
+				auto* const f = Get(buf);
+				f->~F();
+				ThreadPools().Free(f, sizeof(F));
+			}
+
+			static constexpr VTable vtable{&Invoke, &Move, &Destroy};
+		};
+
+	public:
+		Function() noexcept = default;
+		Function(std::nullptr_t) noexcept {}
+
+		template <class F, class D = std::decay_t<F>,
+			class = std::enable_if_t<!std::is_same_v<D, Function> && std::is_invocable_r_v<R, D&, Args...>>>
+		Function(F&& f)
+		{
+			if constexpr (kIsInline<D>)
+			{
+				new (buf_) D{std::forward<F>(f)};
+				vtable_ = &Inline<D>::vtable;
+			}
+			else
+			{
+				static_assert(alignof(D) <= alignof(std::max_align_t));
+				auto* const p = ThreadPools().Alloc(sizeof(D));
+				OMEM_TRY { new (buf_) D*{new (p) D{std::forward<F>(f)}}; }
+				OMEM_CATCH { ThreadPools().Free(p, sizeof(D)); OMEM_RETHROW; }
+				vtable_ = &Spilled<D>::vtable;
+			}
+		}
+
+		Function(Function&& r) noexcept
+			:vtable_{r.vtable_}
+		{
+			if (vtable_) vtable_->move(buf_, r.buf_);
+			r.vtable_ = nullptr;
+		}
+
+		~Function()
+		{
+			if (vtable_) vtable_->destroy(buf_);
+		}
+
+		Function& operator=(Function&& r) noexcept
+		{
+			Function{std::move(r)}.swap(*this);
+			return *this;
+		}
+
+		Function& operator=(std::nullptr_t) noexcept
+		{
+			Function{}.swap(*this);
+			return *this;
+		}
+
+		template <class F, class = decltype(Function{std::declval<F>()})>
+		Function& operator=(F&& f)
+		{
+			Function{std::forward<F>(f)}.swap(*this);
+			return *this;
+		}
+
+		Function(const Function&) = delete;
+		Function& operator=(const Function&) = delete;
+
+		R operator()(Args... args) const
+		{
+			assert(vtable_);
+			return vtable_->invoke(buf_, std::forward<Args>(args)...);
+		}
+
+		[[nodiscard]] explicit operator bool() const noexcept { return vtable_; }
+
+		// Whether the callable is stored inline rather than in a pool block.
+		template <class F>
+		[[nodiscard]] static constexpr bool IsInline() noexcept { return kIsInline<std::decay_t<F>>; }
+
+		void swap(Function& r) noexcept
+		{
+			alignas(std::max_align_t) unsigned char tmp[kBufSize];
+			if (vtable_) vtable_->move(tmp, buf_);
+			if (r.vtable_) r.vtable_->move(buf_, r.buf_);
+			if (vtable_) vtable_->move(r.buf_, tmp);
+			std::swap(vtable_, r.vtable_);
+		}
+
+	private:
+		alignas(std::max_align_t) mutable unsigned char buf_[kBufSize];
+		const VTable* vtable_ = nullptr;
+	};
+}
@@ -0,0 +1,205 @@
+#pragma once
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include <omem.hpp>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace omem
+{
+	// Interns strings into arena chunks and hands out stable string_views and dense 32-bit ids.
+	// The index is an open-addressing table probed 16 slots at a time by comparing 7-bit hash tags
+	// (SSE2 when available). Hashes are stored with each entry, so growth never rehashes strings.
+	// Strings of 4 GiB or more are rejected with std::bad_alloc.
+	template <class Provider = NewChunkProvider>
+	class BasicInternPool
+	{
+		static constexpr size_t kGroup = 16;
+		static constexpr uint8_t kEmpty = 0x80;
+
+		struct Entry
+		{
+			const char* data;
+			uint32_t size;
+			uint32_t hash;
+		};
+
+	public:
+		using Id = uint32_t;
+
+		explicit BasicInternPool(size_t chunk_size = 64 << 10, Provider provider = {})
+			:chunk_size_{chunk_size}, provider_{std::move(provider)}
+		{
+			Rehash(kGroup);
+		}
+
+		~BasicInternPool()
+		{
+			for (auto& [p, size] : chunks_) provider_.Deallocate(p, size);
+		}
+
+		BasicInternPool(const BasicInternPool&) = delete;
+		BasicInternPool& operator=(const BasicInternPool&) = delete;
+
+		Id Intern(std::string_view s)
+		{
+			// Entries store 32-bit lengths.
+			if (s.size() > UINT32_MAX) detail::ThrowBadAlloc();
+			const auto hash = Hash(s);
+			if (const auto id = Lookup(s, hash)) return *id;
+			// Every Id value is taken.
+			if (entries_.size() > std::numeric_limits<Id>::max()) detail::ThrowBadAlloc();
+
+			if ((entries_.size() + 1) * 8 > ctrl_.size() * 7) Rehash(ctrl_.size() * 2);
+
+			const auto id = static_cast<Id>(entries_.size());
+			entries_.push_back({Store(s), static_cast<uint32_t>(s.size()), hash});
+			Insert(id, hash);
+			return id;
+		}
+
+		[[nodiscard]] std::string_view InternView(std::string_view s)
+		{
+			return (*this)[Intern(s)];
+		}
+
+		[[nodiscard]] std::optional<Id> Find(std::string_view s) const noexcept
+		{
+			return Lookup(s, Hash(s));
+		}
+
+		[[nodiscard]] std::string_view operator[](Id id) const noexcept
+		{
+			const auto& e = entries_[id];
+			return {e.data, e.size};
+		}
+
+		[[nodiscard]] size_t Size() const noexcept { return entries_.size(); }
+
+		// Bytes held by string chunks, the entry table and the index.
+		[[nodiscard]] size_t MemoryUsage() const noexcept
+		{
+			size_t bytes = 0;
+			for (auto& c : chunks_) bytes += c.second;
+			return bytes + entries_.capacity() * sizeof(Entry) + ctrl_.size() * (1 + sizeof(Id));
+		}
+
+	private:
+		// The low bits select the group, the top 7 bits are the tag.
+		[[nodiscard]] static uint32_t Hash(std::string_view s) noexcept
+		{
+			const auto h = static_cast<uint64_t>(std::hash<std::string_view>{}(s));
+			return static_cast<uint32_t>(h ^ (h >> 32));
+		}
+
+		[[nodiscard]] static uint8_t Tag(uint32_t hash) noexcept
+		{
+			return static_cast<uint8_t>(hash >> 25);
+		}
+
+		// Bit i is set if ctrl[i] == tag.
+		[[nodiscard]] static uint32_t Match(const uint8_t* ctrl, uint8_t tag) noexcept
+		{
+#ifdef __SSE2__
+			const auto group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+			return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(tag)))));
+#else
+			uint32_t mask = 0;
+			for (size_t i=0; i<kGroup; ++i) mask |= uint32_t(ctrl[i] == tag) << i;
+			return mask;
+#endif
+		}
+
+		[[nodiscard]] std::optional<Id> Lookup(std::string_view s, uint32_t hash) const noexcept
+		{
+			const auto tag = Tag(hash);
+			const auto groups_mask = ctrl_.size() / kGroup - 1;
+			for (size_t g = hash & groups_mask, step = 1;; g = (g + step++) & groups_mask)
+			{
+				const auto* const ctrl = &ctrl_[g * kGroup];
+				for (auto m = Match(ctrl, tag); m; m &= m - 1)
+				{
+					const auto id = slots_[g * kGroup + CountTrailingZeros(m)];
+					const auto& e = entries_[id];
+					if (e.hash == hash && e.size == s.size()
+						&& std::memcmp(e.data, s.data(), s.size()) == 0)
+						return id;
+				}
+				if (Match(ctrl, kEmpty)) return std::nullopt;
+			}
+		}
+
+		void Insert(Id id, uint32_t hash) noexcept
+		{
+			const auto groups_mask = ctrl_.size() / kGroup - 1;
+			for (size_t g = hash & groups_mask, step = 1;; g = (g + step++) & groups_mask)
+			{
+				if (const auto m = Match(&ctrl_[g * kGroup], kEmpty))
+				{
+					const auto i = g * kGroup + CountTrailingZeros(m);
+					ctrl_[i] = Tag(hash);
+					slots_[i] = id;
+					return;
+				}
+			}
+		}
+
+		// Builds the new table aside so a failed allocation leaves the old one intact.
+		void Rehash(size_t capacity)
+		{
+			std::vector<uint8_t> ctrl(capacity, kEmpty);
+			std::vector<Id> slots(capacity);
+			ctrl_.swap(ctrl);
+			slots_.swap(slots);
+			for (size_t id = 0; id < entries_.size(); ++id) Insert(static_cast<Id>(id), entries_[id].hash);
+		}
+
+		// Strings longer than a quarter chunk get a chunk of their own so the current one isn't abandoned.
+		const char* Store(std::string_view s)
+		{
+			if (s.empty()) return "";
+			if (s.size() > left_)
+			{
+				if (s.size() > chunk_size_ / 4)
+				{
+					auto* const p = AllocateChunk(s.size());
+					std::memcpy(p, s.data(), s.size());
+					return p;
+				}
+				cur_ = AllocateChunk(chunk_size_);
+				left_ = chunk_size_;
+			}
+			auto* const p = cur_;
+			std::memcpy(p, s.data(), s.size());
+			cur_ += s.size();
+			left_ -= s.size();
+			return p;
+		}
+
+		char* AllocateChunk(size_t size)
+		{
+			if (chunks_.size() == chunks_.capacity()) chunks_.reserve(chunks_.size() * 2 + 1);
+			auto* const p = provider_.Allocate(size);
+			if (!p) detail::ThrowBadAlloc();
+			chunks_.emplace_back(p, size);
+			return static_cast<char*>(p);
+		}
+
+		std::vector<uint8_t> ctrl_;
+		std::vector<Id> slots_;
+		std::vector<Entry> entries_;
+		std::vector<std::pair<void*, size_t>> chunks_;
+		char* cur_ = nullptr;
+		size_t left_ = 0;
+		size_t chunk_size_;
+		Provider provider_;
+	};
+
+	using InternPool = BasicInternPool<>;
+}
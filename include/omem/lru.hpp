@@ -0,0 +1,197 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <utility>
+#include <omem.hpp>
+
+namespace omem
+{
+	// Fixed-capacity LRU cache. Nodes live in a MemoryPool slab of exactly Capacity() blocks and
+	// carry both the recency list links and the hash chain link. When full, an insert reuses the
+	// least recently used node in place instead of returning it to the pool and allocating again.
+	template <class K, class V, class Hash = std::hash<K>, class Eq = std::equal_to<K>>
+	class LruCache
+	{
+		struct Links
+		{
+			Links* prev;
+			Links* next;
+		};
+
+		struct Node : Links
+		{
+			Node* chain;
+			size_t hash;
+			K key;
+			V value;
+		};
+
+	public:
+		explicit LruCache(size_t capacity, Hash hash = {}, Eq eq = {})
+			:pool_{sizeof(Node), capacity}, capacity_{capacity},
+			mask_{(size_t(1) << LogCeil(std::max<size_t>(capacity, 1), 2)) - 1},
+			buckets_{new Node*[mask_ + 1]{}}, hash_{std::move(hash)}, eq_{std::move(eq)}
+		{
+			assert(capacity > 0);
+			head_.prev = head_.next = &head_;
+		}
+
+		~LruCache()
+		{
+			Clear();
+		}
+
+		LruCache(const LruCache&) = delete;
+		LruCache& operator=(const LruCache&) = delete;
+
+		// Looks up a key and marks it most recently used.
+		[[nodiscard]] V* Get(const K& key)
+		{
+			auto* const n = Find(key, hash_(key));
+			if (!n) return nullptr;
+			Unlink(n);
+			PushFront(n);
+			return &n->value;
+		}
+
+		// Looks up a key without touching recency.
+		[[nodiscard]] const V* Peek(const K& key) const
+		{
+			auto* const n = Find(key, hash_(key));
+			return n ? &n->value : nullptr;
+		}
+
+		// Inserts or overwrites, evicting the least recently used entry when full.
+		template <class KK, class... Args>
+		V& Put(KK&& key, Args&&... args)
+		{
+			const auto hash = hash_(key);
+			if (auto* const n = Find(key, hash))
+			{
+				n->value = V(std::forward<Args>(args)...);
+				Unlink(n);
+				PushFront(n);
+				return n->value;
+			}
+
+			Node* n;
+			if (size_ == capacity_)
+			{
+				n = static_cast<Node*>(head_.prev);
+				Unlink(n);
+				UnlinkChain(n);
+				n->key.~K();
+				n->value.~V();
+				--size_;
+			}
+			else
+			{
+				n = static_cast<Node*>(pool_.Alloc());
+			}
+
+			OMEM_TRY
+			{
+				new (&n->key) K(std::forward<KK>(key));
+				OMEM_TRY { new (&n->value) V(std::forward<Args>(args)...); }
+				OMEM_CATCH { n->key.~K(); OMEM_RETHROW; }
+			}
+			OMEM_CATCH
+			{
+				pool_.Free(n);
+				OMEM_RETHROW;
+			}
+
+			n->hash = hash;
+			auto& bucket = buckets_[hash & mask_];
+			n->chain = bucket;
+			bucket = n;
+			PushFront(n);
+			++size_;
+			return n->value;
+		}
+
+		bool Erase(const K& key)
+		{
+			auto* const n = Find(key, hash_(key));
+			if (!n) return false;
+			Unlink(n);
+			UnlinkChain(n);
+			Destroy(n);
+			--size_;
+			return true;
+		}
+
+		void Clear() noexcept
+		{
+			for (auto* n = head_.next; n != &head_;)
+			{
+				auto* const next = n->next;
+				Destroy(static_cast<Node*>(n));
+				n = next;
+			}
+			head_.prev = head_.next = &head_;
+			std::fill_n(buckets_.get(), mask_ + 1, nullptr);
+			size_ = 0;
+		}
+
+		// Visits entries from most to least recently used.
+		template <class Fn>
+		void ForEach(Fn&& fn) const
+		{
+			for (auto* l = head_.next; l != &head_; l = l->next)
+			{
+				auto* const n = static_cast<const Node*>(l);
+				fn(static_cast<const K&>(n->key), static_cast<const V&>(n->value));
+			}
+		}
+
+		[[nodiscard]] size_t Size() const noexcept { return size_; }
+		[[nodiscard]] size_t Capacity() const noexcept { return capacity_; }
+		[[nodiscard]] const PoolInfo& GetInfo() const noexcept { return pool_.GetInfo(); }
+
+	private:
+		[[nodiscard]] Node* Find(const K& key, size_t hash) const
+		{
+			for (auto* n = buckets_[hash & mask_]; n; n = n->chain)
+				if (n->hash == hash && eq_(n->key, key)) return n;
+			return nullptr;
+		}
+
+		static void Unlink(Links* n) noexcept
+		{
+			n->prev->next = n->next;
+			n->next->prev = n->prev;
+		}
+
+		void PushFront(Links* n) noexcept
+		{
+			n->prev = &head_;
+			n->next = head_.next;
+			head_.next->prev = n;
+			head_.next = n;
+		}
+
+		void UnlinkChain(Node* n) noexcept
+		{
+			auto** it = &buckets_[n->hash & mask_];
+			while (*it != n) it = &(*it)->chain;
+			*it = n->chain;
+		}
+
+		void Destroy(Node* n) noexcept
+		{
+			n->key.~K();
+			n->value.~V();
+			pool_.Free(n);
+		}
+
+		MemoryPool pool_;
+		size_t capacity_;
+		size_t size_ = 0;
+		size_t mask_;
+		std::unique_ptr<Node*[]> buckets_;
+		Links head_;
+		Hash hash_;
+		Eq eq_;
+	};
+}
@@ -0,0 +1,334 @@
+#pragma once
+#include <vector>
+#include <omem/chunk.hpp>
+
+// Pages are views of a memfd, so MeshingPool is only available on POSIX systems, and its
+// constructor throws where memfd_create() is missing.
+#if OMEM_HAS_POSIX
+#include <sys/stat.h>
+
+namespace omem
+{
+	// Fixed-size block pool that can give back memory of sparsely used pages without moving objects
+	// (Powers et al., "Mesh: Compacting Memory Management for C & C++"). Every virtual page is a
+	// MAP_SHARED view of a memfd page. Mesh() finds pairs of pages whose live slots don't overlap,
+	// copies one into the other and points both virtual pages at the same file page, then punches
+	// out the file page no longer used. Pointers stay valid; a meshed slot is free in every view.
+	// Not thread-safe, and no other thread may touch the pool's objects during Mesh(). The views
+	// stay shared across fork(), so parent and child would write the same pages; only one of them
+	// may keep using the pool.
+	class MeshingPool
+	{
+		static constexpr size_t kWords = 4;
+		static constexpr uint32_t kNone = ~uint32_t(0);
+
+		struct Heap
+		{
+			uint64_t bits[kWords];
+			std::vector<uint32_t> pages;
+			off_t offset;
+			uint32_t live;
+			bool partial;   // listed in partial_, which then holds it once
+		};
+
+	public:
+		explicit MeshingPool(size_t size, size_t max_pages = 1 << 18)
+			:page_{PageSize()}, size_{size}, slots_{page_ / size}, max_pages_{max_pages},
+			page_heap_(max_pages, kNone)
+		{
+			assert(size >= page_ / (kWords * 64) && size <= page_);
+			for (size_t w=0; w<kWords; ++w)
+			{
+				const auto first = w * 64;
+				padding_[w] = first >= slots_ ? ~uint64_t(0) : slots_ - first >= 64 ? 0 : ~uint64_t(0) << (slots_ - first);
+			}
+#ifdef MFD_CLOEXEC
+			fd_ = memfd_create("omem-mesh", MFD_CLOEXEC);
+#endif
+			if (fd_ < 0) detail::ThrowBadAlloc();
+			auto* const base = mmap(nullptr, max_pages * page_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+			if (base == MAP_FAILED)
+			{
+				close(fd_);
+				detail::ThrowBadAlloc();
+			}
+			base_ = static_cast<char*>(base);
+		}
+
+		~MeshingPool()
+		{
+			munmap(base_, max_pages_ * page_);
+			close(fd_);
+		}
+
+		MeshingPool(const MeshingPool&) = delete;
+		MeshingPool& operator=(const MeshingPool&) = delete;
+
+		[[nodiscard]] void* Alloc()
+		{
+			while (!partial_.empty() && (heaps_[partial_.back()].pages.empty() || Full(heaps_[partial_.back()])))
+			{
+				heaps_[partial_.back()].partial = false;
+				partial_.pop_back();
+			}
+			if (partial_.empty())
+			{
+				const auto idx = NewHeap();
+				heaps_[idx].partial = true;
+				partial_.push_back(idx);
+			}
+
+			auto& h = heaps_[partial_.back()];
+			size_t slot = 0;
+			for (size_t w=0; w<kWords; ++w)
+			{
+				if (~h.bits[w])
+				{
+					slot = w * 64 + CountTrailingZeros(~h.bits[w]);
+					break;
+				}
+			}
+			h.bits[slot / 64] |= uint64_t(1) << (slot % 64);
+			++h.live;
+			return base_ + h.pages[0] * page_ + slot * size_;
+		}
+
+		void Free(void* p) noexcept
+		{
+			const auto off = static_cast<size_t>(static_cast<char*>(p) - base_);
+			const auto idx = page_heap_[off / page_];
+			auto& h = heaps_[idx];
+			const auto slot = off % page_ / size_;
+			const auto was_full = Full(h);
+			h.bits[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+			--h.live;
+			// The last page is kept so that a single object going back and forth doesn't map and punch.
+			if (h.live == 0 && heaps_.size() - free_heaps_.size() > 1) ReleaseHeap(idx);
+			else if (was_full && !h.partial)
+			{
+				h.partial = true;
+				partial_.push_back(idx);
+			}
+		}
+
+		// Meshes pairs of disjoint pages. Returns the bytes of file pages released.
+		size_t Mesh()
+		{
+			std::vector<uint32_t> candidates;
+			for (uint32_t i=0; i<heaps_.size(); ++i)
+				if (!heaps_[i].pages.empty() && heaps_[i].live * 2 <= slots_) candidates.push_back(i);
+			std::sort(candidates.begin(), candidates.end(),
+				[&](uint32_t a, uint32_t b) { return heaps_[a].live < heaps_[b].live; });
+
+			constexpr size_t kProbes = 64;
+			size_t released = 0;
+			std::vector<bool> done(candidates.size());
+			for (size_t i=0; i<candidates.size(); ++i)
+			{
+				if (done[i]) continue;
+				for (size_t j=i+1; j<candidates.size() && j<=i+kProbes; ++j)
+				{
+					if (done[j] || !Disjoint(heaps_[candidates[i]], heaps_[candidates[j]])) continue;
+					MeshInto(candidates[j], candidates[i]);
+					done[i] = done[j] = true;
+					released += page_;
+					break;
+				}
+			}
+
+			partial_.clear();
+			for (uint32_t i=0; i<heaps_.size(); ++i)
+			{
+				auto& h = heaps_[i];
+				h.partial = !h.pages.empty() && !Full(h);
+				if (h.partial) partial_.push_back(i);
+			}
+			return released;
+		}
+
+		// Bytes of memfd pages actually backed by memory.
+		[[nodiscard]] size_t PhysicalBytes() const noexcept
+		{
+			struct stat st{};
+			fstat(fd_, &st);
+			return static_cast<size_t>(st.st_blocks) * 512;
+		}
+
+		[[nodiscard]] size_t GetLive() const noexcept
+		{
+			size_t n = 0;
+			for (auto& h : heaps_) n += h.live;
+			return n;
+		}
+
+		[[nodiscard]] size_t GetSize() const noexcept { return size_; }
+
+	private:
+		[[nodiscard]] bool Full(const Heap& h) const noexcept { return h.live == slots_; }
+
+		// Slots past slots_ are kept set so that allocation never picks them.
+		[[nodiscard]] bool Disjoint(const Heap& a, const Heap& b) const noexcept
+		{
+			for (size_t w=0; w<kWords; ++w)
+				if (a.bits[w] & b.bits[w] & ~padding_[w]) return false;
+			return true;
+		}
+
+		[[nodiscard]] bool TryMapPage(uint32_t page, off_t offset) noexcept
+		{
+			return mmap(base_ + page * page_, page_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd_, offset) != MAP_FAILED;
+		}
+
+		void MapPage(uint32_t page, off_t offset)
+		{
+			if (!TryMapPage(page, offset)) detail::ThrowBadAlloc();
+		}
+
+		// Grows geometrically so that reserving one more each time stays amortized O(1).
+		template <class T>
+		static void ReserveFor(std::vector<T>& v, size_t n)
+		{
+			if (v.capacity() < n) v.reserve(std::max(n, v.capacity() * 2));
+		}
+
+		void UnmapPage(uint32_t page) noexcept
+		{
+			mmap(base_ + page * page_, page_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+		}
+
+		void PunchHole(off_t offset) noexcept
+		{
+#ifdef FALLOC_FL_PUNCH_HOLE
+			fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, static_cast<off_t>(page_));
+#endif
+			free_offsets_.push_back(offset);
+		}
+
+		// Only peeks at the free lists until the page is mapped, so a failure leaves the pool as it was.
+		// Every list that Free() and Mesh() push to is reserved for all heaps, pages and file pages
+		// there could be after this one, so those never allocate.
+		uint32_t NewHeap()
+		{
+			const auto reuse_heap = !free_heaps_.empty();
+			const auto idx = reuse_heap ? free_heaps_.back() : static_cast<uint32_t>(heaps_.size());
+			if (!reuse_heap) heaps_.emplace_back();
+
+			const auto reuse_page = !free_pages_.empty();
+			const auto page = reuse_page ? free_pages_.back() : next_page_;
+			const auto reuse_offset = !free_offsets_.empty();
+			const auto offset = reuse_offset ? free_offsets_.back() : file_size_;
+			auto grown = false;
+			OMEM_TRY
+			{
+				heaps_[idx].pages.reserve(1);
+				ReserveFor(partial_, heaps_.size());
+				ReserveFor(free_heaps_, heaps_.size());
+				ReserveFor(free_pages_, size_t(next_page_) + 1);
+				ReserveFor(free_offsets_, static_cast<size_t>(file_size_) / page_ + 1);
+				if (page == max_pages_) detail::ThrowBadAlloc();
+				if (!reuse_offset)
+				{
+					if (ftruncate(fd_, file_size_ + static_cast<off_t>(page_)) != 0) detail::ThrowBadAlloc();
+					grown = true;
+				}
+				MapPage(page, offset);
+			}
+			OMEM_CATCH
+			{
+				// A failed MAP_FIXED may have dropped the reservation.
+				if (page < max_pages_) UnmapPage(page);
+				if (grown) (void)!ftruncate(fd_, file_size_);
+				if (!reuse_heap) heaps_.pop_back();
+				OMEM_RETHROW;
+			}
+
+			if (reuse_heap) free_heaps_.pop_back();
+			if (reuse_page) free_pages_.pop_back();
+			else ++next_page_;
+			if (reuse_offset) free_offsets_.pop_back();
+			else file_size_ += static_cast<off_t>(page_);
+
+			auto& h = heaps_[idx];
+			std::copy_n(padding_, kWords, h.bits);
+			h.pages.assign(1, page);
+			h.offset = offset;
+			h.live = 0;
+			h.partial = false;
+			page_heap_[page] = idx;
+			return idx;
+		}
+
+		void ReleaseHeap(uint32_t idx) noexcept
+		{
+			auto& h = heaps_[idx];
+			for (auto page : h.pages)
+			{
+				UnmapPage(page);
+				page_heap_[page] = kNone;
+				free_pages_.push_back(page);
+			}
+			PunchHole(h.offset);
+			h.pages.clear();
+			free_heaps_.push_back(idx);
+		}
+
+		// Copies the live objects of heap from into heap to and remaps from's virtual pages onto to's file page.
+		// Nothing is recorded until every page is remapped, so a failure leaves both heaps as they were.
+		void MeshInto(uint32_t from, uint32_t to)
+		{
+			auto& f = heaps_[from];
+			auto& t = heaps_[to];
+			t.pages.reserve(t.pages.size() + f.pages.size());
+			auto* const src = base_ + f.pages[0] * page_;
+			auto* const dst = base_ + t.pages[0] * page_;
+			for (size_t w=0; w<kWords; ++w)
+			{
+				for (auto bits = f.bits[w] & ~padding_[w]; bits; bits &= bits - 1)
+				{
+					const auto slot = w * 64 + CountTrailingZeros(bits);
+					std::memcpy(dst + slot * size_, src + slot * size_, size_);
+				}
+			}
+
+			size_t mapped = 0;
+			OMEM_TRY
+			{
+				for (; mapped < f.pages.size(); ++mapped) MapPage(f.pages[mapped], t.offset);
+			}
+			OMEM_CATCH
+			{
+				// from's file page is still intact. The failed MAP_FIXED may have dropped its page too.
+				for (size_t i=0; i<=mapped && i<f.pages.size(); ++i) (void)TryMapPage(f.pages[i], f.offset);
+				OMEM_RETHROW;
+			}
+			for (auto page : f.pages)
+			{
+				page_heap_[page] = to;
+				t.pages.push_back(page);
+			}
+			for (size_t w=0; w<kWords; ++w) t.bits[w] |= f.bits[w];
+			t.live += f.live;
+
+			PunchHole(f.offset);
+			f.pages.clear();
+			free_heaps_.push_back(from);
+		}
+
+		size_t page_;
+		size_t size_;
+		size_t slots_;
+		size_t max_pages_;
+		uint64_t padding_[kWords];
+		char* base_ = nullptr;
+		int fd_ = -1;
+		off_t file_size_ = 0;
+		uint32_t next_page_ = 0;
+		std::vector<Heap> heaps_;
+		std::vector<uint32_t> page_heap_;
+		std::vector<uint32_t> partial_;
+		std::vector<uint32_t> free_pages_;
+		std::vector<uint32_t> free_heaps_;
+		std::vector<off_t> free_offsets_;
+	};
+}
+#endif
@@ -0,0 +1,109 @@
+#pragma once
+#include <omem.hpp>
+
+namespace omem
+{
+	struct EventCounts
+	{
+		size_t alloc = 0;
+		size_t free = 0;
+		size_t fault = 0;
+		size_t grow = 0;
+		size_t trim = 0;
+		size_t grown_bytes = 0;
+		size_t trimmed_bytes = 0;
+	};
+
+	// Counts events of every pool using it, separately for each thread.
+	class CountingObserver
+	{
+	public:
+		[[nodiscard]] static EventCounts& ThreadCounts() noexcept
+		{
+			thread_local EventCounts counts;
+			return counts;
+		}
+
+		void OnAlloc(const PoolInfo&, void*) noexcept { ++ThreadCounts().alloc; }
+		void OnFree(const PoolInfo&, void*) noexcept { ++ThreadCounts().free; }
+		void OnFault(const PoolInfo&, void*) noexcept { ++ThreadCounts().fault; }
+
+		void OnGrow(const PoolInfo&, void*, size_t bytes) noexcept
+		{
+			auto& c = ThreadCounts();
+			++c.grow;
+			c.grown_bytes += bytes;
+		}
+
+		void OnTrim(const PoolInfo&, void*, size_t bytes) noexcept
+		{
+			auto& c = ThreadCounts();
+			++c.trim;
+			c.trimmed_bytes += bytes;
+		}
+	};
+
+	struct TraceEvent
+	{
+		enum class Type : uint8_t { kAlloc, kFree, kFault, kGrow, kTrim };
+
+		uint64_t time;
+		const void* ptr;
+		size_t size;
+		Type type;
+	};
+
+	// Fixed-size ring that keeps the most recent events.
+	class TraceRing
+	{
+	public:
+		static constexpr size_t kCapacity = 4096;
+
+		void Push(const TraceEvent& e) noexcept
+		{
+			events_[head_++ % kCapacity] = e;
+		}
+
+		// Visits the retained events from oldest to newest, then empties the ring.
+		template <class Fn>
+		void Drain(Fn&& fn)
+		{
+			const auto size = std::min<uint64_t>(head_ - tail_, kCapacity);
+			dropped_ += head_ - tail_ - size;
+			for (auto i = head_ - size; i != head_; ++i) fn(events_[i % kCapacity]);
+			tail_ = head_;
+		}
+
+		[[nodiscard]] size_t Size() const noexcept { return static_cast<size_t>(std::min<uint64_t>(head_ - tail_, kCapacity)); }
+		[[nodiscard]] uint64_t Dropped() const noexcept { return dropped_; }
+
+	private:
+		TraceEvent events_[kCapacity];
+		uint64_t head_ = 0;
+		uint64_t tail_ = 0;
+		uint64_t dropped_ = 0;
+	};
+
+	// Records timestamped events into the calling thread's TraceRing.
+	class TraceObserver
+	{
+	public:
+		[[nodiscard]] static TraceRing& ThreadRing() noexcept
+		{
+			thread_local TraceRing ring;
+			return ring;
+		}
+
+		void OnAlloc(const PoolInfo& info, void* p) noexcept { Push(TraceEvent::Type::kAlloc, p, info.size); }
+		void OnFree(const PoolInfo& info, void* p) noexcept { Push(TraceEvent::Type::kFree, p, info.size); }
+		void OnFault(const PoolInfo& info, void* p) noexcept { Push(TraceEvent::Type::kFault, p, info.size); }
+		void OnGrow(const PoolInfo&, void* p, size_t bytes) noexcept { Push(TraceEvent::Type::kGrow, p, bytes); }
+		void OnTrim(const PoolInfo&, void* p, size_t bytes) noexcept { Push(TraceEvent::Type::kTrim, p, bytes); }
+
+	private:
+		static void Push(TraceEvent::Type type, const void* p, size_t size) noexcept
+		{
+			ThreadRing().Push({ReadClock(), p, size, type});
+		}
+	};
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <omem.hpp>
+
+namespace omem
+{
+	// Purges cached memory when the kernel reports memory pressure (PSI, /proc/pressure/memory or a
+	// cgroup's memory.pressure). Poll() reads the "some avg10" figure, the share of the last 10 s in
+	// which some task stalled on memory, and once it reaches the threshold runs every registered
+	// purge callback and bumps Epoch(). Callbacks run on the polling thread; thread-local managers
+	// can't be purged from there, so their threads call Check() from time to time instead.
+	class PressureMonitor
+	{
+	public:
+		explicit PressureMonitor(std::string path = "/proc/pressure/memory", double threshold = 10.0)
+			:path_{std::move(path)}, threshold_{threshold}
+		{
+		}
+
+		~PressureMonitor() { Stop(); }
+
+		PressureMonitor(const PressureMonitor&) = delete;
+		PressureMonitor& operator=(const PressureMonitor&) = delete;
+
+		// Adds a callback that releases memory and returns the bytes released. Returns a handle for Unregister().
+		// Callbacks run without the monitor's lock held, so they may register and unregister, and one
+		// may still be running from a concurrent Poll() when Unregister() returns.
+		size_t Register(std::function<size_t()> purge)
+		{
+			std::lock_guard<std::mutex> lock{mutex_};
+			callbacks_.emplace_back(++next_, std::move(purge));
+			return next_;
+		}
+
+		void Unregister(size_t handle)
+		{
+			std::lock_guard<std::mutex> lock{mutex_};
+			callbacks_.erase(std::remove_if(callbacks_.begin(), callbacks_.end(),
+				[&](auto& c) { return c.first == handle; }), callbacks_.end());
+		}
+
+		// The current "some avg10" percentage, or nothing if the file is missing or malformed.
+		[[nodiscard]] std::optional<double> ReadAvg10() const
+		{
+			auto* const file = std::fopen(path_.c_str(), "r");
+			if (!file) return std::nullopt;
+			double avg10;
+			const auto n = std::fscanf(file, "some avg10=%lf", &avg10);
+			std::fclose(file);
+			if (n != 1) return std::nullopt;
+			return avg10;
+		}
+
+		// Purges if under pressure. Returns the bytes released by the callbacks.
+		size_t Poll()
+		{
+			const auto avg10 = ReadAvg10();
+			if (!avg10 || *avg10 < threshold_) return 0;
+
+			epoch_.fetch_add(1, std::memory_order_release);
+			decltype(callbacks_) callbacks;
+			{
+				std::lock_guard<std::mutex> lock{mutex_};
+				callbacks = callbacks_;
+			}
+			size_t bytes = 0;
+			for (auto& [handle, purge] : callbacks) bytes += purge();
+			return bytes;
+		}
+
+		// Registers manager.Trim() as a purge callback and returns its handle for Unregister(). The
+		// manager is trimmed on the polling thread, so no other thread may use it during Poll().
+		template <class Manager>
+		size_t Watch(Manager& manager)
+		{
+			return Register([&manager] { return manager.Trim(); });
+		}
+
+		// Trims the calling thread's manager if there was pressure since the epoch in seen. Returns the bytes released.
+		template <class Manager = MemoryPoolManager>
+		size_t Check(uint64_t& seen, Manager& manager = ThreadPools())
+		{
+			const auto epoch = Epoch();
+			if (epoch == seen) return 0;
+			seen = epoch;
+			return manager.Trim();
+		}
+
+		[[nodiscard]] uint64_t Epoch() const noexcept { return epoch_.load(std::memory_order_acquire); }
+
+		// Polls every interval on a background thread until Stop(). Callbacks must then be thread-safe.
+		void Start(std::chrono::milliseconds interval = std::chrono::seconds{1})
+		{
+			Stop();
+			stop_ = false;
+			thread_ = std::thread{[this, interval]
+			{
+				std::unique_lock<std::mutex> lock{stop_mutex_};
+				while (!stop_cv_.wait_for(lock, interval, [&] { return stop_; }))
+				{
+					lock.unlock();
+					Poll();
+					lock.lock();
+				}
+			}};
+		}
+
+		void Stop()
+		{
+			if (!thread_.joinable()) return;
+			{
+				std::lock_guard<std::mutex> lock{stop_mutex_};
+				stop_ = true;
+			}
+			stop_cv_.notify_one();
+			thread_.join();
+		}
+
+	private:
+		std::string path_;
+		double threshold_;
+		std::atomic<uint64_t> epoch_{0};
+		std::mutex mutex_;
+		std::vector<std::pair<size_t, std::function<size_t()>>> callbacks_;
+		size_t next_ = 0;
+		std::thread thread_;
+		std::mutex stop_mutex_;
+		std::condition_variable stop_cv_;
+		bool stop_ = false;
+	};
+}
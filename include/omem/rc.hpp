@@ -0,0 +1,207 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <omem.hpp>
+
+namespace omem
+{
+	namespace detail
+	{
+		template <class Node>
+		[[nodiscard]] size_t RcPoolCount() noexcept
+		{
+			return std::max<size_t>(GetConfig().PoolSize(LogCeil(sizeof(Node), 2)) / sizeof(Node), 1);
+		}
+	}
+
+	// Reference count for objects confined to one thread. Nodes come from a thread-local pool.
+	struct NonAtomicRefCount
+	{
+		using Type = size_t;
+
+		static void Increment(Type& c) noexcept { ++c; }
+		[[nodiscard]] static bool Decrement(Type& c) noexcept { return --c == 0; }
+		[[nodiscard]] static size_t Load(const Type& c) noexcept { return c; }
+
+		template <class Node>
+		[[nodiscard]] static MemoryPool& Pool()
+		{
+			thread_local MemoryPool pool{sizeof(Node), detail::RcPoolCount<Node>()};
+			return pool;
+		}
+
+		template <class Node>
+		[[nodiscard]] static void* Alloc() { return Pool<Node>().Alloc(); }
+
+		template <class Node>
+		static void Free(void* p) noexcept { Pool<Node>().Free(p); }
+	};
+
+	// Reference count shared between threads. Nodes come from a process-wide pool behind a mutex.
+	struct AtomicRefCount
+	{
+		using Type = std::atomic<size_t>;
+
+		static void Increment(Type& c) noexcept { c.fetch_add(1, std::memory_order_relaxed); }
+		[[nodiscard]] static bool Decrement(Type& c) noexcept { return c.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+		[[nodiscard]] static size_t Load(const Type& c) noexcept { return c.load(std::memory_order_relaxed); }
+
+		template <class Node>
+		struct LockedPool
+		{
+			std::mutex mutex;
+			MemoryPool pool{sizeof(Node), detail::RcPoolCount<Node>()};
+		};
+
+		template <class Node>
+		[[nodiscard]] static LockedPool<Node>& Pool()
+		{
+			static LockedPool<Node> pool;
+			return pool;
+		}
+
+		template <class Node>
+		[[nodiscard]] static void* Alloc()
+		{
+			auto& p = Pool<Node>();
+			std::lock_guard<std::mutex> lock{p.mutex};
+			return p.pool.Alloc();
+		}
+
+		template <class Node>
+		static void Free(void* ptr) noexcept
+		{
+			auto& p = Pool<Node>();
+			std::lock_guard<std::mutex> lock{p.mutex};
+			p.pool.Free(ptr);
+		}
+	};
+
+	// Intrusive reference-counted pointer. The count and the object share one pooled block
+	// of exactly sizeof(Node) bytes, which is returned to the pool on the last release.
+	// The pools are thread_local (Rc) or static (Arc): an Rc must be released on the thread that
+	// made it before that thread exits, and neither may be released during static destruction.
+	template <class T, class Policy>
+	class BasicRc
+	{
+		struct Node
+		{
+			// Parentheses like std::make_shared, braces for aggregates
+			template <class... Args, std::enable_if_t<std::is_constructible_v<T, Args...>, int> = 0>
+			explicit Node(Args&&... args)
+				:count{1}, value(std::forward<Args>(args)...)
+			{
+			}
+
+			template <class... Args, std::enable_if_t<!std::is_constructible_v<T, Args...>, int> = 0>
+			explicit Node(Args&&... args)
+				:count{1}, value{std::forward<Args>(args)...}
+			{
+			}
+
+			typename Policy::Type count;
+			T value;
+		};
+
+		template <class U, class P, class... Args>
+		friend BasicRc<U, P> MakeBasicRc(Args&&... args);
+
+	public:
+		using element_type = T;
+
+		constexpr BasicRc() noexcept = default;
+		constexpr BasicRc(std::nullptr_t) noexcept {}
+
+		BasicRc(const BasicRc& r) noexcept
+			:node_{r.node_}
+		{
+			if (node_) Policy::Increment(node_->count);
+		}
+
+		BasicRc(BasicRc&& r) noexcept
+			:node_{std::exchange(r.node_, nullptr)}
+		{
+		}
+
+		~BasicRc()
+		{
+			Release();
+		}
+
+		BasicRc& operator=(const BasicRc& r) noexcept
+		{
+			BasicRc{r}.swap(*this);
+			return *this;
+		}
+
+		BasicRc& operator=(BasicRc&& r) noexcept
+		{
+			BasicRc{std::move(r)}.swap(*this);
+			return *this;
+		}
+
+		void Reset() noexcept
+		{
+			Release();
+			node_ = nullptr;
+		}
+
+		[[nodiscard]] T* Get() const noexcept { return node_ ? &node_->value : nullptr; }
+		[[nodiscard]] T& operator*() const noexcept { return node_->value; }
+		[[nodiscard]] T* operator->() const noexcept { return &node_->value; }
+		[[nodiscard]] explicit operator bool() const noexcept { return node_; }
+		[[nodiscard]] size_t UseCount() const noexcept { return node_ ? Policy::Load(node_->count) : 0; }
+
+		[[nodiscard]] friend bool operator==(const BasicRc& a, const BasicRc& b) noexcept { return a.node_ == b.node_; }
+		[[nodiscard]] friend bool operator!=(const BasicRc& a, const BasicRc& b) noexcept { return a.node_ != b.node_; }
+
+		void swap(BasicRc& r) noexcept
+		{
+			std::swap(node_, r.node_);
+		}
+
+	private:
+		void Release() noexcept
+		{
+			if (node_ && Policy::Decrement(node_->count))
+			{
+				node_->~Node();
+				Policy::template Free<Node>(node_);
+			}
+		}
+
+		Node* node_ = nullptr;
+	};
+
+	template <class T, class Policy, class... Args>
+	[[nodiscard]] BasicRc<T, Policy> MakeBasicRc(Args&&... args)
+	{
+		static_assert(alignof(T) <= alignof(std::max_align_t), "pool blocks are only aligned to max_align_t");
+		using Node = typename BasicRc<T, Policy>::Node;
+		auto* const p = Policy::template Alloc<Node>();
+		BasicRc<T, Policy> rc;
+		OMEM_TRY { rc.node_ = new (p) Node{std::forward<Args>(args)...}; }
+		OMEM_CATCH { Policy::template Free<Node>(p); OMEM_RETHROW; }
+		return rc;
+	}
+
+	template <class T>
+	using Rc = BasicRc<T, NonAtomicRefCount>;
+
+	template <class T>
+	using Arc = BasicRc<T, AtomicRefCount>;
+
+	template <class T, class... Args>
+	[[nodiscard]] Rc<T> MakeRc(Args&&... args)
+	{
+		return MakeBasicRc<T, NonAtomicRefCount>(std::forward<Args>(args)...);
+	}
+
+	template <class T, class... Args>
+	[[nodiscard]] Arc<T> MakeArc(Args&&... args)
+	{
+		return MakeBasicRc<T, AtomicRefCount>(std::forward<Args>(args)...);
+	}
+}
@@ -0,0 +1,193 @@
+#pragma once
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <omem.hpp>
+
+namespace omem
+{
+	// Vector of fixed power-of-two sized segments drawn from a MemoryPoolManager. Elements never
+	// move, growth never copies, and indexing is a shift and a mask. One emptied segment is kept
+	// as a spare so that oscillating around a segment boundary doesn't hit the manager.
+	template <class T, size_t SegmentBytes = 4096>
+	class SegmentedVector
+	{
+		static_assert(sizeof(T) <= SegmentBytes, "a segment must hold at least one element");
+		static_assert(alignof(T) <= alignof(std::max_align_t), "pool blocks are only aligned to max_align_t");
+
+		static constexpr size_t kShift = LogCeil(SegmentBytes / sizeof(T) + 1, 2) - 1;
+
+	public:
+		static constexpr size_t kSegmentSize = size_t(1) << kShift;
+
+		template <bool Const>
+		class Iterator
+		{
+			using Owner = std::conditional_t<Const, const SegmentedVector, SegmentedVector>;
+
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type = T;
+			using difference_type = ptrdiff_t;
+			using pointer = std::conditional_t<Const, const T*, T*>;
+			using reference = std::conditional_t<Const, const T&, T&>;
+
+			Iterator() noexcept = default;
+			Iterator(Owner* v, size_t i) noexcept :v_{v}, i_{i} {}
+
+			reference operator*() const noexcept { return (*v_)[i_]; }
+			pointer operator->() const noexcept { return &(*v_)[i_]; }
+			reference operator[](difference_type n) const noexcept { return (*v_)[i_ + n]; }
+
+			Iterator& operator++() noexcept { ++i_; return *this; }
+			Iterator& operator--() noexcept { --i_; return *this; }
+			Iterator operator++(int) noexcept { return {v_, i_++}; }
+			Iterator operator--(int) noexcept { return {v_, i_--}; }
+			Iterator& operator+=(difference_type n) noexcept { i_ += n; return *this; }
+			Iterator& operator-=(difference_type n) noexcept { i_ -= n; return *this; }
+			Iterator operator+(difference_type n) const noexcept { return {v_, i_ + n}; }
+			Iterator operator-(difference_type n) const noexcept { return {v_, i_ - n}; }
+			difference_type operator-(const Iterator& r) const noexcept { return difference_type(i_) - difference_type(r.i_); }
+
+			bool operator==(const Iterator& r) const noexcept { return i_ == r.i_; }
+			bool operator!=(const Iterator& r) const noexcept { return i_ != r.i_; }
+			bool operator<(const Iterator& r) const noexcept { return i_ < r.i_; }
+			bool operator>(const Iterator& r) const noexcept { return i_ > r.i_; }
+			bool operator<=(const Iterator& r) const noexcept { return i_ <= r.i_; }
+			bool operator>=(const Iterator& r) const noexcept { return i_ >= r.i_; }
+
+		private:
+			Owner* v_ = nullptr;
+			size_t i_ = 0;
+		};
+
+		using iterator = Iterator<false>;
+		using const_iterator = Iterator<true>;
+
+		explicit SegmentedVector(MemoryPoolManager& pools = ThreadPools()) noexcept
+			:pools_{&pools}
+		{
+		}
+
+		SegmentedVector(SegmentedVector&& r) noexcept
+			:segments_{std::move(r.segments_)}, pools_{r.pools_},
+			spare_{std::exchange(r.spare_, nullptr)}, size_{std::exchange(r.size_, 0)}
+		{
+		}
+
+		~SegmentedVector()
+		{
+			Clear();
+			ReleaseSpare();
+		}
+
+		SegmentedVector& operator=(SegmentedVector&& r) noexcept
+		{
+			SegmentedVector{std::move(r)}.swap(*this);
+			return *this;
+		}
+
+		SegmentedVector(const SegmentedVector&) = delete;
+		SegmentedVector& operator=(const SegmentedVector&) = delete;
+
+		template <class... Args>
+		T& EmplaceBack(Args&&... args)
+		{
+			const auto off = size_ & (kSegmentSize - 1);
+			const auto added = off == 0 && (size_ >> kShift) == segments_.size();
+			if (added) AddSegment();
+			T* p;
+			OMEM_TRY { p = new (&segments_[size_ >> kShift][off]) T(std::forward<Args>(args)...); }
+			OMEM_CATCH
+			{
+				// Keep the segment as the spare so the destructor returns it.
+				if (added) RemoveSegment();
+				OMEM_RETHROW;
+			}
+			++size_;
+			return *p;
+		}
+
+		void PushBack(const T& x) { EmplaceBack(x); }
+		void PushBack(T&& x) { EmplaceBack(std::move(x)); }
+
+		void PopBack() noexcept
+		{
+			assert(size_ > 0);
+			--size_;
+			segments_[size_ >> kShift][size_ & (kSegmentSize - 1)].~T();
+			if ((size_ & (kSegmentSize - 1)) == 0) RemoveSegment();
+		}
+
+		void Resize(size_t n)
+		{
+			while (size_ > n) PopBack();
+			while (size_ < n) EmplaceBack();
+		}
+
+		void Clear() noexcept
+		{
+			while (size_) PopBack();
+		}
+
+		[[nodiscard]] T& operator[](size_t i) noexcept
+		{
+			assert(i < size_);
+			return segments_[i >> kShift][i & (kSegmentSize - 1)];
+		}
+
+		[[nodiscard]] const T& operator[](size_t i) const noexcept
+		{
+			assert(i < size_);
+			return segments_[i >> kShift][i & (kSegmentSize - 1)];
+		}
+
+		[[nodiscard]] T& Front() noexcept { return (*this)[0]; }
+		[[nodiscard]] T& Back() noexcept { return (*this)[size_ - 1]; }
+		[[nodiscard]] size_t Size() const noexcept { return size_; }
+		[[nodiscard]] bool Empty() const noexcept { return size_ == 0; }
+		[[nodiscard]] size_t SegmentCount() const noexcept { return segments_.size(); }
+
+		[[nodiscard]] iterator begin() noexcept { return {this, 0}; }
+		[[nodiscard]] iterator end() noexcept { return {this, size_}; }
+		[[nodiscard]] const_iterator begin() const noexcept { return {this, 0}; }
+		[[nodiscard]] const_iterator end() const noexcept { return {this, size_}; }
+
+		void swap(SegmentedVector& r) noexcept
+		{
+			using std::swap;
+			swap(segments_, r.segments_);
+			swap(pools_, r.pools_);
+			swap(spare_, r.spare_);
+			swap(size_, r.size_);
+		}
+
+	private:
+		static constexpr size_t kBytes = kSegmentSize * sizeof(T);
+
+		void AddSegment()
+		{
+			if (segments_.size() == segments_.capacity()) segments_.reserve(segments_.size() * 2 + 1);
+			auto* const seg = spare_ ? std::exchange(spare_, nullptr) : static_cast<T*>(pools_->Alloc(kBytes));
+			segments_.push_back(seg);
+		}
+
+		void RemoveSegment() noexcept
+		{
+			ReleaseSpare();
+			spare_ = segments_.back();
+			segments_.pop_back();
+		}
+
+		void ReleaseSpare() noexcept
+		{
+			if (spare_) pools_->Free(std::exchange(spare_, nullptr), kBytes);
+		}
+
+		std::vector<T*> segments_;
+		MemoryPoolManager* pools_;
+		T* spare_ = nullptr;
+		size_t size_ = 0;
+	};
+}
@@ -0,0 +1,245 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <omem.hpp>
+
+namespace omem
+{
+	// Structure-of-arrays pool. Live slots are kept densely packed in chunks of ChunkSlots entries,
+	// each chunk holding one Align-aligned column per field, so per-field scans are contiguous and
+	// vectorizable. Handles index a sparse table recycled through a free-slot stack; freeing moves
+	// the last live slot into the hole, keeping alloc and free O(1). Chunks come from Provider and
+	// are over-allocated when Align exceeds the max_align_t alignment providers guarantee.
+	template <class Provider, size_t ChunkSlots, size_t Align, class... Fields>
+	class BasicSoAPool
+	{
+		static_assert((std::is_nothrow_move_assignable_v<Fields> && ...));
+		static_assert(ChunkSlots > 0 && (ChunkSlots & (ChunkSlots - 1)) == 0);
+		static_assert(Align > 0 && (Align & (Align - 1)) == 0);
+		static constexpr size_t kShift = LogCeil(ChunkSlots, 2);
+		static constexpr size_t kCount = sizeof...(Fields);
+
+		template <size_t I>
+		using Field = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+		[[nodiscard]] static constexpr size_t ColumnBytes(size_t size) noexcept
+		{
+			return (size * ChunkSlots + Align - 1) / Align * Align;
+		}
+
+		template <size_t... I>
+		[[nodiscard]] static constexpr auto Offsets(std::index_sequence<I...>) noexcept
+		{
+			std::array<size_t, kCount + 1> offsets{};
+			constexpr size_t sizes[] = {sizeof(Field<I>)...};
+			for (size_t i=0; i<kCount; ++i) offsets[i+1] = offsets[i] + ColumnBytes(sizes[i]);
+			return offsets;
+		}
+
+		static constexpr auto kOffsets = Offsets(std::index_sequence_for<Fields...>{});
+		static constexpr size_t kChunkBytes = kOffsets[kCount];
+		static constexpr size_t kAllocBytes = kChunkBytes
+			+ (Align > alignof(std::max_align_t) ? Align - alignof(std::max_align_t) : 0);
+
+		struct Chunk
+		{
+			void* block;
+			char* data;
+		};
+
+		struct Entry
+		{
+			uint32_t dense;
+			uint32_t generation;
+		};
+
+	public:
+		struct Handle
+		{
+			uint32_t index;
+			uint32_t generation;
+		};
+
+		static constexpr size_t kChunkSlots = ChunkSlots;
+
+		explicit BasicSoAPool(Provider provider = {})
+			:provider_{std::move(provider)}
+		{
+		}
+
+		~BasicSoAPool()
+		{
+			Clear();
+			for (auto& c : chunks_) provider_.Deallocate(c.block, kAllocBytes);
+		}
+
+		BasicSoAPool(const BasicSoAPool&) = delete;
+		BasicSoAPool& operator=(const BasicSoAPool&) = delete;
+
+		template <class... Args>
+		Handle Alloc(Args&&... args)
+		{
+			if (size_ == chunks_.size() * ChunkSlots) AddChunk();
+			if (free_.empty() && sparse_.size() == sparse_.capacity())
+			{
+				// free_ never outgrows sparse_, so keeping them level lets Free stay noexcept.
+				sparse_.reserve(sparse_.size() * 2 + 1);
+				free_.reserve(sparse_.capacity());
+			}
+			if (dense_.size() == dense_.capacity()) dense_.reserve(dense_.size() * 2 + 1);
+
+			// Nothing is claimed until the fields are built, so a throwing constructor leaves no trace.
+			Construct(size_, std::index_sequence_for<Fields...>{}, std::forward<Args>(args)...);
+
+			uint32_t index;
+			if (free_.empty())
+			{
+				index = static_cast<uint32_t>(sparse_.size());
+				sparse_.push_back({0, 0});
+			}
+			else
+			{
+				index = free_.back();
+				free_.pop_back();
+			}
+			dense_.push_back(index);
+			sparse_[index].dense = static_cast<uint32_t>(size_++);
+			return {index, sparse_[index].generation};
+		}
+
+		void Free(Handle h) noexcept
+		{
+			assert(IsValid(h));
+			auto& e = sparse_[h.index];
+			const auto hole = e.dense, last = static_cast<uint32_t>(--size_);
+			if (hole != last)
+			{
+				MoveSlot(hole, last, std::index_sequence_for<Fields...>{});
+				sparse_[dense_[last]].dense = hole;
+				dense_[hole] = dense_[last];
+			}
+			DestroySlot(last, std::index_sequence_for<Fields...>{});
+			dense_.pop_back();
+			++e.generation;
+			free_.push_back(h.index);
+		}
+
+		void Clear() noexcept
+		{
+			while (size_) Free({dense_[size_ - 1], sparse_[dense_[size_ - 1]].generation});
+		}
+
+		[[nodiscard]] bool IsValid(Handle h) const noexcept
+		{
+			return h.index < sparse_.size() && sparse_[h.index].generation == h.generation
+				&& sparse_[h.index].dense < size_ && dense_[sparse_[h.index].dense] == h.index;
+		}
+
+		template <size_t I>
+		[[nodiscard]] Field<I>& Get(Handle h) noexcept
+		{
+			assert(IsValid(h));
+			return At<I>(sparse_[h.index].dense);
+		}
+
+		template <size_t I>
+		[[nodiscard]] const Field<I>& Get(Handle h) const noexcept
+		{
+			return const_cast<BasicSoAPool*>(this)->template Get<I>(h);
+		}
+
+		// Column I of a chunk; the first ChunkLive(chunk) entries are live.
+		template <size_t I>
+		[[nodiscard]] Field<I>* Column(size_t chunk) noexcept
+		{
+			return std::launder(reinterpret_cast<Field<I>*>(chunks_[chunk].data + kOffsets[I]));
+		}
+
+		[[nodiscard]] size_t ChunkLive(size_t chunk) const noexcept
+		{
+			return std::min(ChunkSlots, size_ - std::min(size_, chunk * ChunkSlots));
+		}
+
+		[[nodiscard]] size_t ChunkCount() const noexcept { return (size_ + ChunkSlots - 1) >> kShift; }
+
+		// Calls fn(n, column<I>...) for every chunk with live entries.
+		template <size_t... I, class Fn>
+		void ForEachChunk(Fn&& fn)
+		{
+			for (size_t c=0, n=ChunkCount(); c<n; ++c)
+				fn(ChunkLive(c), Column<I>(c)...);
+		}
+
+		[[nodiscard]] size_t Size() const noexcept { return size_; }
+
+		[[nodiscard]] Provider& GetProvider() noexcept { return provider_; }
+
+	private:
+		void AddChunk()
+		{
+			if (chunks_.size() == chunks_.capacity()) chunks_.reserve(chunks_.size() * 2 + 1);
+			auto* const p = provider_.Allocate(kAllocBytes);
+			if (!p) detail::ThrowBadAlloc();
+			const auto addr = (reinterpret_cast<uintptr_t>(p) + Align - 1) & ~uintptr_t{Align - 1};
+			chunks_.push_back({p, static_cast<char*>(p) + (addr - reinterpret_cast<uintptr_t>(p))});
+		}
+
+		template <size_t I>
+		[[nodiscard]] Field<I>& At(size_t slot) noexcept
+		{
+			return Column<I>(slot >> kShift)[slot & (ChunkSlots - 1)];
+		}
+
+		// Destroys the fields already built if a later one throws.
+		template <size_t... I, class... Args>
+		void Construct(size_t slot, std::index_sequence<I...>, Args&&... args)
+		{
+			size_t built = 0;
+			OMEM_TRY
+			{
+				if constexpr (sizeof...(Args) == 0)
+				{
+					((new (&At<I>(slot)) Field<I>{}, ++built), ...);
+				}
+				else
+				{
+					static_assert(sizeof...(Args) == kCount, "provide either no values or one per field");
+					((new (&At<I>(slot)) Field<I>(std::forward<Args>(args)), ++built), ...);
+				}
+			}
+			OMEM_CATCH
+			{
+				((I < built ? std::destroy_at(&At<I>(slot)) : void()), ...);
+				OMEM_RETHROW;
+			}
+		}
+
+		template <size_t... I>
+		void MoveSlot(size_t dst, size_t src, std::index_sequence<I...>) noexcept
+		{
+			((At<I>(dst) = std::move(At<I>(src))), ...);
+		}
+
+		template <size_t... I>
+		void DestroySlot(size_t slot, std::index_sequence<I...>) noexcept
+		{
+			(std::destroy_at(&At<I>(slot)), ...);
+		}
+
+		Provider provider_;
+		std::vector<Chunk> chunks_;
+		std::vector<Entry> sparse_;
+		std::vector<uint32_t> dense_;
+		std::vector<uint32_t> free_;
+		size_t size_ = 0;
+	};
+
+	template <class... Fields>
+	using SoAPool = BasicSoAPool<NewChunkProvider, 1024, 64, Fields...>;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <vector>
+#include <omem/chunk.hpp>
+
+// Stacks are mmap()ed with a guard page, so StackPool is only available on POSIX systems.
+#if OMEM_HAS_POSIX
+namespace omem
+{
+	// Usable range of a stack; a PROT_NONE guard page sits right below base.
+	struct Stack
+	{
+		[[nodiscard]] void* Top() const noexcept { return static_cast<char*>(base) + size; }
+
+		void* base;
+		size_t size;
+	};
+
+	// Caches fiber stacks in power-of-two classes from 64 KiB to 1 MiB. Stacks are mapped lazily, so
+	// only touched pages are committed. A returned stack keeps its top Keep() bytes resident and gives
+	// the deeper pages back with MADV_DONTNEED, so a deep recursion doesn't pin memory in the cache.
+	// Larger stacks are mapped and unmapped on every call. Not thread-safe; see ThreadStacks().
+	class StackPool
+	{
+	public:
+		static constexpr size_t kMinLog = 16;
+		static constexpr size_t kMaxLog = 20;
+
+		// The caches are reserved up front so that Free() never allocates.
+		explicit StackPool(size_t max_cached = 16, size_t keep = 16 << 10)
+			:max_cached_{max_cached}, keep_{keep}
+		{
+			for (auto& cache : cache_) cache.reserve(max_cached);
+		}
+
+		~StackPool()
+		{
+			for (size_t i=0; i<=kMaxLog-kMinLog; ++i)
+				for (auto& s : cache_[i]) Unmap(s);
+		}
+
+		StackPool(const StackPool&) = delete;
+		StackPool& operator=(const StackPool&) = delete;
+
+		[[nodiscard]] Stack Alloc(size_t size)
+		{
+			const auto log = std::max(LogCeil(size, 2), kMinLog);
+			if (log <= kMaxLog)
+			{
+				auto& cache = cache_[log - kMinLog];
+				if (!cache.empty())
+				{
+					const auto s = cache.back();
+					cache.pop_back();
+					return s;
+				}
+			}
+			return Map(size_t(1) << log);
+		}
+
+		void Free(const Stack& s) noexcept
+		{
+			const auto log = LogCeil(s.size, 2);
+			if (log > kMaxLog || cache_[log - kMinLog].size() >= max_cached_)
+			{
+				Unmap(s);
+				return;
+			}
+
+			if (s.size > keep_)
+			{
+				const auto keep = (keep_ + PageSize() - 1) / PageSize() * PageSize();
+				madvise(s.base, s.size - keep, MADV_DONTNEED);
+			}
+
+			cache_[log - kMinLog].push_back(s);
+		}
+
+		[[nodiscard]] size_t Cached(size_t size) const noexcept
+		{
+			const auto log = std::max(LogCeil(size, 2), kMinLog);
+			return log <= kMaxLog ? cache_[log - kMinLog].size() : 0;
+		}
+
+		[[nodiscard]] size_t Keep() const noexcept { return keep_; }
+
+	private:
+		[[nodiscard]] static Stack Map(size_t size)
+		{
+			const auto guard = PageSize();
+			auto flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+#ifdef MAP_STACK
+			flags |= MAP_STACK;
+#endif
+			auto* const p = static_cast<char*>(mmap(nullptr, size + guard, PROT_READ | PROT_WRITE, flags, -1, 0));
+			if (p == MAP_FAILED) detail::ThrowBadAlloc();
+			if (mprotect(p, guard, PROT_NONE) != 0)
+			{
+				munmap(p, size + guard);
+				detail::ThrowBadAlloc();
+			}
+			return {p + guard, size};
+		}
+
+		static void Unmap(const Stack& s) noexcept
+		{
+			munmap(static_cast<char*>(s.base) - PageSize(), s.size + PageSize());
+		}
+
+		std::vector<Stack> cache_[kMaxLog - kMinLog + 1];
+		size_t max_cached_;
+		size_t keep_;
+	};
+
+	// The calling thread's stack cache. A stack may be returned to any thread's cache.
+	[[nodiscard]] inline StackPool& ThreadStacks()
+	{
+		thread_local StackPool stacks;
+		return stacks;
+	}
+}
+#endif
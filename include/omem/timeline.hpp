@@ -0,0 +1,190 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <omem/chunk.hpp>
+
+namespace omem
+{
+	// Resident set size of the process in bytes, or 0 where it can't be read.
+	[[nodiscard]] inline size_t ResidentBytes() noexcept
+	{
+		auto* const file = std::fopen("/proc/self/statm", "r");
+		if (!file) return 0;
+		unsigned long long size = 0, resident = 0;
+		const auto n = std::fscanf(file, "%llu %llu", &size, &resident);
+		std::fclose(file);
+		return n == 2 ? static_cast<size_t>(resident) * PageSize() : 0;
+	}
+
+	struct TimelineSample
+	{
+		struct Class
+		{
+			size_t cur;
+			size_t reserved;
+			size_t fault;
+		};
+
+		uint64_t time;             // nanoseconds since the timeline was created
+		size_t rss;
+		const char* event;         // nullptr for periodic samples
+		uint64_t classes;          // bit log is set if classes[log] is filled
+		Class cls[Config::kMaxClasses];
+	};
+
+	// Records how a manager's memory use changes over time: per-class blocks in use, reserved pool
+	// bytes and fault counts, plus process RSS, into a fixed ring of the most recent samples.
+	// The owner of the manager calls Tick() from its loop; a sample is taken once interval has passed,
+	// or right away when fault_spike faults or more happened since the last sample. Trigger() marks
+	// an event and, post_event samples later, freezes the ring so that the history around the event
+	// is kept until Resume(). Event names must outlive the timeline and are written out verbatim.
+	class HeapTimeline
+	{
+		using Clock = std::chrono::steady_clock;
+
+	public:
+		explicit HeapTimeline(std::chrono::nanoseconds interval = std::chrono::milliseconds{100}, size_t capacity = 256,
+			size_t fault_spike = 0, size_t post_event = 64)
+			:samples_(capacity), start_{Clock::now()}, next_{start_}, interval_{interval},
+			fault_spike_{fault_spike}, post_event_{std::min(post_event, capacity - 1)}
+		{
+			assert(capacity > 0);
+		}
+
+		// Samples if it is time to. Returns whether a sample was taken.
+		template <class Manager>
+		bool Tick(const Manager& manager)
+		{
+			if (frozen_) return false;
+			const auto now = Clock::now();
+			if (now >= next_)
+			{
+				Record(manager, nullptr, now);
+				return true;
+			}
+			if (fault_spike_ && Faults(manager) - last_faults_ >= fault_spike_)
+			{
+				Trigger(manager, "fault_spike");
+				return true;
+			}
+			return false;
+		}
+
+		// Takes a sample now, labelled with event if given.
+		template <class Manager>
+		void Record(const Manager& manager, const char* event = nullptr)
+		{
+			if (!frozen_) Record(manager, event, Clock::now());
+		}
+
+		// Records an event sample and freezes the ring post_event samples later.
+		template <class Manager>
+		void Trigger(const Manager& manager, const char* event)
+		{
+			if (frozen_) return;
+			if (!remaining_) remaining_ = post_event_ + 1;
+			Record(manager, event, Clock::now());
+		}
+
+		// Resumes recording after a triggered freeze.
+		void Resume() noexcept
+		{
+			frozen_ = false;
+			remaining_ = 0;
+		}
+
+		[[nodiscard]] bool Frozen() const noexcept { return frozen_; }
+		[[nodiscard]] size_t Size() const noexcept { return static_cast<size_t>(std::min<uint64_t>(head_, samples_.size())); }
+		[[nodiscard]] size_t Capacity() const noexcept { return samples_.size(); }
+
+		// Visits the retained samples from oldest to newest.
+		template <class Fn>
+		void ForEach(Fn&& fn) const
+		{
+			for (auto i = head_ - Size(); i != head_; ++i) fn(samples_[i % samples_.size()]);
+		}
+
+		// One row per sample and size class.
+		void WriteCsv(std::FILE* out) const
+		{
+			std::fputs("time_ns,rss,event,size,cur,reserved,fault\n", out);
+			ForEach([&](const TimelineSample& s)
+			{
+				auto classes = s.classes;
+				do
+				{
+					const auto log = classes ? static_cast<size_t>(CountTrailingZeros(classes)) : 0;
+					const auto c = classes ? s.cls[log] : TimelineSample::Class{};
+					std::fprintf(out, "%llu,%zu,%s,%zu,%zu,%zu,%zu\n", static_cast<unsigned long long>(s.time), s.rss,
+						s.event ? s.event : "", classes ? size_t(1) << log : 0, c.cur, c.reserved, c.fault);
+					classes &= classes - 1;
+				} while (classes);
+			});
+		}
+
+		void WriteJson(std::FILE* out) const
+		{
+			std::fputc('[', out);
+			auto first = true;
+			ForEach([&](const TimelineSample& s)
+			{
+				std::fprintf(out, "%s\n{\"time_ns\":%llu,\"rss\":%zu,\"event\":", first ? "" : ",",
+					static_cast<unsigned long long>(s.time), s.rss);
+				if (s.event) std::fprintf(out, "\"%s\"", s.event);
+				else std::fputs("null", out);
+				std::fputs(",\"classes\":[", out);
+				for (auto classes = s.classes; classes; classes &= classes - 1)
+				{
+					const auto log = static_cast<size_t>(CountTrailingZeros(classes));
+					const auto& c = s.cls[log];
+					std::fprintf(out, "%s{\"size\":%zu,\"cur\":%zu,\"reserved\":%zu,\"fault\":%zu}",
+						classes == s.classes ? "" : ",", size_t(1) << log, c.cur, c.reserved, c.fault);
+				}
+				std::fputs("]}", out);
+				first = false;
+			});
+			std::fputs("\n]\n", out);
+		}
+
+	private:
+		template <class Manager>
+		[[nodiscard]] static size_t Faults(const Manager& manager) noexcept
+		{
+			size_t faults = 0;
+			for (auto& [log, pool] : manager.Pools()) faults += pool.GetInfo().fault;
+			return faults;
+		}
+
+		template <class Manager>
+		void Record(const Manager& manager, const char* event, Clock::time_point now)
+		{
+			auto& s = samples_[head_++ % samples_.size()];
+			s.time = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_).count());
+			s.rss = ResidentBytes();
+			s.event = event;
+			s.classes = 0;
+			last_faults_ = 0;
+			for (auto& [log, pool] : manager.Pools())
+			{
+				const auto& info = pool.GetInfo();
+				s.classes |= uint64_t(1) << log;
+				s.cls[log] = {info.cur, pool.GetReserved(), info.fault};
+				last_faults_ += info.fault;
+			}
+			next_ = now + interval_;
+			if (remaining_ && --remaining_ == 0) frozen_ = true;
+		}
+
+		std::vector<TimelineSample> samples_;
+		uint64_t head_ = 0;
+		Clock::time_point start_;
+		Clock::time_point next_;
+		std::chrono::nanoseconds interval_;
+		size_t fault_spike_;
+		size_t post_event_;
+		size_t last_faults_ = 0;
+		size_t remaining_ = 0;
+		bool frozen_ = false;
+	};
+}
@@ -0,0 +1,219 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <omem.hpp>
+
+namespace omem
+{
+	// Whether objects can be moved with memcpy and the source forgotten. Specialize for types that
+	// are not trivially copyable but don't care about their address (e.g. unique_ptr-like handles).
+	template <class T>
+	struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+	// Contiguous vector drawn from a MemoryPoolManager. Capacity always fills the size class, and
+	// trivially relocatable elements grow through Manager::Realloc, which stays in place within a
+	// class and lets large blocks be remapped instead of copied.
+	template <class T, class Manager = MemoryPoolManager>
+	class Vector
+	{
+		static_assert(alignof(T) <= alignof(std::max_align_t), "pool blocks are only aligned to max_align_t");
+
+		static constexpr bool kRelocatable = IsTriviallyRelocatable<T>::value;
+
+	public:
+		using iterator = T*;
+		using const_iterator = const T*;
+
+		explicit Vector(Manager& pools = ThreadPools()) noexcept
+			:pools_{&pools}
+		{
+		}
+
+		Vector(Vector&& r) noexcept
+			:pools_{r.pools_}, data_{std::exchange(r.data_, nullptr)},
+			size_{std::exchange(r.size_, 0)}, capacity_{std::exchange(r.capacity_, 0)}
+		{
+		}
+
+		~Vector()
+		{
+			Clear();
+			if (data_) pools_->Free(data_, capacity_ * sizeof(T));
+		}
+
+		Vector& operator=(Vector&& r) noexcept
+		{
+			Vector{std::move(r)}.swap(*this);
+			return *this;
+		}
+
+		Vector(const Vector&) = delete;
+		Vector& operator=(const Vector&) = delete;
+
+		template <class... Args>
+		T& EmplaceBack(Args&&... args)
+		{
+			if (size_ == capacity_) return EmplaceGrow(std::forward<Args>(args)...);
+			auto* const p = new (data_ + size_) T(std::forward<Args>(args)...);
+			++size_;
+			return *p;
+		}
+
+		void PushBack(const T& x) { EmplaceBack(x); }
+		void PushBack(T&& x) { EmplaceBack(std::move(x)); }
+
+		void PopBack() noexcept
+		{
+			assert(size_ > 0);
+			data_[--size_].~T();
+		}
+
+		void Reserve(size_t n)
+		{
+			if (n <= capacity_) return;
+			const auto bytes = BlockSize(n);
+			if constexpr (kRelocatable)
+			{
+				data_ = static_cast<T*>(data_
+					? pools_->Realloc(data_, capacity_ * sizeof(T), bytes)
+					: pools_->Alloc(bytes));
+			}
+			else
+			{
+				auto* const p = static_cast<T*>(pools_->Alloc(bytes));
+				OMEM_TRY { MoveTo(p); }
+				OMEM_CATCH
+				{
+					pools_->Free(p, bytes);
+					OMEM_RETHROW;
+				}
+				if (data_) pools_->Free(data_, capacity_ * sizeof(T));
+				data_ = p;
+			}
+			capacity_ = bytes / sizeof(T);
+		}
+
+		void Resize(size_t n)
+		{
+			while (size_ > n) PopBack();
+			Reserve(n);
+			while (size_ < n) EmplaceBack();
+		}
+
+		void Clear() noexcept
+		{
+			std::destroy(data_, data_ + size_);
+			size_ = 0;
+		}
+
+		[[nodiscard]] T& operator[](size_t i) noexcept { assert(i < size_); return data_[i]; }
+		[[nodiscard]] const T& operator[](size_t i) const noexcept { assert(i < size_); return data_[i]; }
+
+		[[nodiscard]] T& Front() noexcept { return (*this)[0]; }
+		[[nodiscard]] const T& Front() const noexcept { return (*this)[0]; }
+		[[nodiscard]] T& Back() noexcept { return (*this)[size_ - 1]; }
+		[[nodiscard]] const T& Back() const noexcept { return (*this)[size_ - 1]; }
+
+		[[nodiscard]] T* Data() noexcept { return data_; }
+		[[nodiscard]] const T* Data() const noexcept { return data_; }
+		[[nodiscard]] size_t Size() const noexcept { return size_; }
+		[[nodiscard]] size_t Capacity() const noexcept { return capacity_; }
+		[[nodiscard]] bool Empty() const noexcept { return size_ == 0; }
+
+		[[nodiscard]] iterator begin() noexcept { return data_; }
+		[[nodiscard]] iterator end() noexcept { return data_ + size_; }
+		[[nodiscard]] const_iterator begin() const noexcept { return data_; }
+		[[nodiscard]] const_iterator end() const noexcept { return data_ + size_; }
+
+		void swap(Vector& r) noexcept
+		{
+			using std::swap;
+			swap(pools_, r.pools_);
+			swap(data_, r.data_);
+			swap(size_, r.size_);
+			swap(capacity_, r.capacity_);
+		}
+
+	private:
+		[[nodiscard]] size_t BlockSize(size_t n) const
+		{
+			if (n > SIZE_MAX / sizeof(T)) detail::ThrowBadAlloc();
+			return pools_->UsableSize(n * sizeof(T));
+		}
+
+		template <class... Args>
+		T& EmplaceGrow(Args&&... args)
+		{
+			if (capacity_ > SIZE_MAX / 2) detail::ThrowBadAlloc();
+			const auto n = capacity_ ? capacity_ * 2 : 1;
+			if constexpr (kRelocatable)
+			{
+				// Realloc may release the old block, so only use it when args don't point into it.
+				if (!PointsInto(args...))
+				{
+					Reserve(n);
+					auto* const p = new (data_ + size_) T(std::forward<Args>(args)...);
+					++size_;
+					return *p;
+				}
+			}
+
+			// Construct the new element before moving the old ones, which args may refer to.
+			const auto bytes = BlockSize(n);
+			auto* const p = static_cast<T*>(pools_->Alloc(bytes));
+			auto* const x = p + size_;
+			OMEM_TRY { new (x) T(std::forward<Args>(args)...); }
+			OMEM_CATCH
+			{
+				pools_->Free(p, bytes);
+				OMEM_RETHROW;
+			}
+			OMEM_TRY { MoveTo(p); }
+			OMEM_CATCH
+			{
+				x->~T();
+				pools_->Free(p, bytes);
+				OMEM_RETHROW;
+			}
+			if (data_) pools_->Free(data_, capacity_ * sizeof(T));
+			data_ = p;
+			capacity_ = bytes / sizeof(T);
+			++size_;
+			return *x;
+		}
+
+		// Moves the elements to p and destroys the originals. Types whose move may throw are copied
+		// when they can be, so a failure leaves the elements as they were.
+		void MoveTo(T* p)
+		{
+			if constexpr (kRelocatable)
+			{
+				if (size_) std::memcpy(static_cast<void*>(p), static_cast<const void*>(data_), size_ * sizeof(T));
+			}
+			else
+			{
+				if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
+					std::uninitialized_move(data_, data_ + size_, p);
+				else
+					std::uninitialized_copy(data_, data_ + size_, p);
+				std::destroy(data_, data_ + size_);
+			}
+		}
+
+		template <class... Args>
+		[[nodiscard]] bool PointsInto(const Args&... args) const noexcept
+		{
+			const auto lo = reinterpret_cast<uintptr_t>(data_);
+			const auto len = capacity_ * sizeof(T);
+			return ((reinterpret_cast<uintptr_t>(std::addressof(args)) - lo < len) || ...);
+		}
+
+		Manager* pools_;
+		T* data_ = nullptr;
+		size_t size_ = 0;
+		size_t capacity_ = 0;
+	};
+}
@@ -0,0 +1,193 @@
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <gtest/gtest.h>
+#include <omem/arena.hpp>
+
+TEST(arena, alloc)
+{
+	omem::Arena arena{4096};
+	auto* const a = static_cast<char*>(arena.Alloc(10, 1));
+	auto* const b = static_cast<char*>(arena.Alloc(8, 8));
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 8, 0);
+	EXPECT_GE(b, a + 10);
+	EXPECT_EQ(arena.Reserved(), 4096);
+
+	auto* const big = arena.Alloc(10000);
+	EXPECT_NE(big, nullptr);
+	EXPECT_GT(arena.Reserved(), 4096 + 10000);
+
+	const auto reserved = arena.Reserved();
+	arena.Reset();
+	EXPECT_EQ(arena.Used(), 0);
+	for (auto i=0; i<50; ++i) (void)arena.Alloc(64);
+	(void)arena.Alloc(10000);
+	EXPECT_EQ(arena.Reserved(), reserved);
+
+	arena.Release();
+	EXPECT_EQ(arena.Reserved(), 0);
+}
+
+TEST(arena, detach_adopt)
+{
+	omem::Arena a{4096}, b{4096};
+	auto* const x = a.New<int>(42);
+	for (auto i=0; i<200; ++i) (void)a.Alloc(64);
+	const auto used = a.Used();
+
+	auto blocks = a.Detach();
+	EXPECT_EQ(a.Used(), 0);
+	EXPECT_EQ(blocks.Reserved(), used);
+
+	b.Adopt(std::move(blocks));
+	EXPECT_TRUE(blocks.Empty());
+	EXPECT_EQ(b.Used(), used);
+	EXPECT_EQ(*x, 42);
+
+	b.Reset();
+	EXPECT_EQ(b.Reserved(), used);
+}
+
+TEST(arena, handoff)
+{
+	omem::Arena arena;
+	auto* const x = arena.New<long>(7);
+	auto blocks = arena.Detach();
+
+	long seen = 0;
+	std::thread{[&, blocks = std::move(blocks)]() mutable
+	{
+		seen = *x;
+		blocks.Release();
+	}}.join();
+	EXPECT_EQ(seen, 7);
+
+	arena.Unbind();
+	std::thread{[&] { (void)arena.New<long>(8); arena.Unbind(); }}.join();
+	arena.Reset();
+
+	omem::MemoryPoolManager manager;
+	auto* const p = manager.Alloc(32);
+	std::thread{[&] { manager.Free(p, 32); }}.join();
+	EXPECT_EQ(manager.Get(32).GetInfo().cur, 0);
+}
+
+#ifndef NDEBUG
+TEST(arena, ownership)
+{
+	omem::Arena arena;
+	(void)arena.New<long>(1);
+	EXPECT_DEATH(std::thread{[&] { (void)arena.New<long>(2); }}.join(), "");
+}
+#endif
+
+namespace
+{
+	constexpr auto kRequests = 200000;
+	constexpr auto kObjects = 16;
+
+	struct Object
+	{
+		long data[6];
+	};
+
+	template <class T>
+	class Channel
+	{
+	public:
+		void Push(T x)
+		{
+			{
+				std::lock_guard<std::mutex> lock{mutex_};
+				queue_.push_back(std::move(x));
+			}
+			cv_.notify_one();
+		}
+
+		T Pop()
+		{
+			std::unique_lock<std::mutex> lock{mutex_};
+			cv_.wait(lock, [&] { return !queue_.empty(); });
+			auto x = std::move(queue_.front());
+			queue_.pop_front();
+			return x;
+		}
+
+		bool TryPop(T& x)
+		{
+			std::lock_guard<std::mutex> lock{mutex_};
+			if (queue_.empty()) return false;
+			x = std::move(queue_.front());
+			queue_.pop_front();
+			return true;
+		}
+
+	private:
+		std::mutex mutex_;
+		std::condition_variable cv_;
+		std::deque<T> queue_;
+	};
+
+	struct Request
+	{
+		Object* objects[kObjects];
+		omem::ArenaBlocks<> blocks;
+	};
+}
+
+// Every object is freed by the consumer thread.
+TEST(arena, bench_cross_thread_free)
+{
+	Channel<Request*> channel;
+	std::thread consumer{[&]
+	{
+		for (auto i=0; i<kRequests; ++i)
+		{
+			auto* const r = channel.Pop();
+			for (auto* o : r->objects) delete o;
+			delete r;
+		}
+	}};
+
+	for (auto i=0; i<kRequests; ++i)
+	{
+		auto* const r = new Request;
+		for (auto& o : r->objects) o = new Object{{i}};
+		channel.Push(r);
+	}
+	consumer.join();
+}
+
+// Each request is built in an arena and its chunks travel with it; the consumer sends them back
+// to be adopted and reused.
+TEST(arena, bench_arena_handoff)
+{
+	Channel<Request*> channel;
+	Channel<omem::ArenaBlocks<>> back;
+	std::thread consumer{[&]
+	{
+		for (auto i=0; i<kRequests; ++i)
+		{
+			auto* const r = channel.Pop();
+			long sum = 0;
+			for (auto* o : r->objects) sum += o->data[0];
+			EXPECT_EQ(sum, i * kObjects);
+			back.Push(std::move(r->blocks));
+		}
+	}};
+
+	omem::Arena arena{4096};
+	for (auto i=0; i<kRequests; ++i)
+	{
+		omem::ArenaBlocks<> blocks;
+		while (back.TryPop(blocks)) arena.Adopt(std::move(blocks));
+		arena.Reset();
+
+		auto* const r = arena.New<Request>();
+		for (auto& o : r->objects) o = arena.New<Object>(Object{{i}});
+		r->blocks = arena.Detach();
+		channel.Push(r);
+	}
+	consumer.join();
+}
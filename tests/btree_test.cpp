@@ -0,0 +1,270 @@
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <gtest/gtest.h>
+#include <omem/btree.hpp>
+
+namespace
+{
+	uint64_t Next(uint64_t& x)
+	{
+		x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+		return x;
+	}
+}
+
+TEST(btree, layout)
+{
+	using M = omem::BTreeMap<long, long>;
+	EXPECT_EQ(M::kLeafCapacity, 15);
+	EXPECT_EQ(M::kInnerCapacity, 14);
+}
+
+TEST(btree, basic)
+{
+	omem::BTreeMap<int, int> m;
+	EXPECT_TRUE(m.Insert(1, 10).second);
+	EXPECT_FALSE(m.Insert(1, 20).second);
+	EXPECT_EQ(m.Find(1).Value(), 10);
+	EXPECT_EQ(m.Find(2), m.end());
+	m[2] = 5;
+	EXPECT_EQ(m.Size(), 2);
+
+	for (auto i=1000; i>2; --i) m[i] = i;
+	EXPECT_EQ(m.Size(), 1000);
+	auto expect = 1;
+	for (auto [k, v] : m) EXPECT_EQ(k, expect++);
+	EXPECT_EQ(m.LowerBound(500).Key(), 500);
+	EXPECT_EQ(m.LowerBound(1001), m.end());
+
+	for (auto i=1; i<=1000; i+=2) EXPECT_TRUE(m.Erase(i));
+	EXPECT_FALSE(m.Erase(1));
+	EXPECT_EQ(m.Size(), 500);
+	EXPECT_EQ(m.LowerBound(499).Key(), 500);
+	for (auto i=2; i<=1000; i+=2) EXPECT_TRUE(m.Erase(i));
+	EXPECT_TRUE(m.Empty());
+	EXPECT_EQ(m.begin(), m.end());
+}
+
+TEST(btree, random)
+{
+	omem::BTreeMap<uint32_t, std::string> m;
+	std::map<uint32_t, std::string> ref;
+	uint64_t x = 88172645463325252ull;
+	for (auto i=0; i<200000; ++i)
+	{
+		const auto k = static_cast<uint32_t>(Next(x) % 5000);
+		if (Next(x) % 3)
+		{
+			const auto v = std::to_string(k) + std::string(20, 'x');
+			ASSERT_EQ(m.Insert(k, v).second, ref.emplace(k, v).second);
+		}
+		else
+		{
+			ASSERT_EQ(m.Erase(k), ref.erase(k) == 1);
+		}
+	}
+
+	ASSERT_EQ(m.Size(), ref.size());
+	auto it = ref.begin();
+	for (auto [k, v] : m)
+	{
+		ASSERT_EQ(k, it->first);
+		ASSERT_EQ(v, it->second);
+		++it;
+	}
+
+	const auto& c = m;
+	for (uint32_t k=0; k<5000; k+=7)
+	{
+		const auto a = c.LowerBound(k);
+		const auto b = ref.lower_bound(k);
+		ASSERT_EQ(a == c.end(), b == ref.end());
+		if (b != ref.end())
+		{
+			ASSERT_EQ(a.Key(), b->first);
+		}
+	}
+
+	m.Clear();
+	EXPECT_TRUE(m.Empty());
+	const auto reserved = m.MemoryUsage();
+	EXPECT_GT(reserved, 0);
+
+	// Freed nodes from every pool are reused before a new pool is added. Keys go back in random
+	// order, since sorted inserts leave every leaf half full and need more nodes than before.
+	while (m.Size() < ref.size())
+	{
+		const auto it = ref.find(static_cast<uint32_t>(Next(x) % 5000));
+		if (it != ref.end()) m.Insert(it->first, it->second);
+	}
+	EXPECT_EQ(m.MemoryUsage(), reserved);
+}
+
+TEST(btree, small_map)
+{
+	omem::BTreeMap<int, int> m;
+	m[1] = 1;
+	EXPECT_EQ(m.MemoryUsage(), 4096);
+	for (auto i=0; i<10000; ++i) m[i] = i;
+	EXPECT_LT(m.MemoryUsage(), 10000 * 256 / 5);
+}
+
+namespace
+{
+	struct Throwing
+	{
+		static inline int left = -1;
+
+		Throwing() = default;
+		Throwing(int) { if (left >= 0 && left-- == 0) throw std::runtime_error{"copy"}; }
+	};
+}
+
+TEST(btree, throwing_value)
+{
+	omem::BTreeMap<int, Throwing> m;
+	std::map<int, int> ref;
+	for (auto i=0; i<2000; i+=2)
+	{
+		m.TryEmplace(i, 0);
+		ref.emplace(i, 0);
+	}
+	for (auto i=1; i<2000; i+=2)
+	{
+		Throwing::left = 0;
+		EXPECT_THROW(m.TryEmplace(i, 0), std::runtime_error);
+		ASSERT_EQ(m.Size(), ref.size());
+		ASSERT_FALSE(m.Contains(i));
+		if (i % 3 == 0)
+		{
+			Throwing::left = -1;
+			m.TryEmplace(i, 0);
+			ref.emplace(i, 0);
+		}
+	}
+	auto it = ref.begin();
+	for (auto [k, v] : m) ASSERT_EQ(k, (it++)->first);
+	EXPECT_EQ(it, ref.end());
+}
+
+namespace
+{
+	struct ThrowingKey
+	{
+		static inline int left = -1;
+
+		ThrowingKey(int v) :v{v} {}
+		ThrowingKey(const ThrowingKey&) = default;
+		ThrowingKey(ThrowingKey&&) noexcept = default;
+		ThrowingKey& operator=(ThrowingKey&&) noexcept = default;
+
+		ThrowingKey& operator=(const ThrowingKey& r)
+		{
+			if (left >= 0 && left-- == 0) throw std::runtime_error{"copy"};
+			v = r.v;
+			return *this;
+		}
+
+		bool operator<(const ThrowingKey& r) const noexcept { return v < r.v; }
+
+		int v;
+	};
+}
+
+TEST(btree, throwing_separator_copy)
+{
+	omem::BTreeMap<ThrowingKey, int> m;
+	std::set<int> ref;
+	for (auto i=0; i<2000; ++i)
+	{
+		m.Insert(i, i);
+		ref.insert(i);
+	}
+
+	auto throws = 0;
+	for (auto i=0; i<2000; i+=3)
+	{
+		// Fail now and then, so that a node isn't left underfull again before it is rebalanced.
+		if (i % 9 == 0) ThrowingKey::left = 0;
+		try { EXPECT_TRUE(m.Erase(i)); }
+		catch (const std::runtime_error&) { ++throws; }
+		ThrowingKey::left = -1;
+		ref.erase(i);
+		ASSERT_EQ(m.Size(), ref.size());
+		ASSERT_FALSE(m.Contains(i));
+	}
+	EXPECT_GT(throws, 0);
+
+	auto it = ref.begin();
+	for (auto [k, v] : m) ASSERT_EQ(k.v, *it++);
+	EXPECT_EQ(it, ref.end());
+	for (auto k : ref) ASSERT_TRUE(m.Contains(k));
+}
+
+namespace
+{
+	constexpr auto kN = 1 << 20;
+
+	template <class T>
+	struct PoolAllocator
+	{
+		using value_type = T;
+
+		PoolAllocator() noexcept = default;
+		template <class U> PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+		T* allocate(size_t n) { return static_cast<T*>(omem::ThreadPools().Alloc(n * sizeof(T))); }
+		void deallocate(T* p, size_t n) noexcept { omem::ThreadPools().Free(p, n * sizeof(T)); }
+
+		template <class U> bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+		template <class U> bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+	};
+
+	template <class M>
+	void Insert(M& m, long k) { m.emplace(k, k); }
+	void Insert(omem::BTreeMap<long, long>& m, long k) { m.Insert(k, k); }
+
+	template <class M>
+	long Lookup(M& m, long k) { return m.find(k)->second; }
+	long Lookup(omem::BTreeMap<long, long>& m, long k) { return m.Find(k).Value(); }
+
+	template <class M>
+	auto LowerBound(M& m, long k) { return m.lower_bound(k); }
+	auto LowerBound(omem::BTreeMap<long, long>& m, long k) { return m.LowerBound(k); }
+
+	template <class M>
+	void Benchmark()
+	{
+		M m;
+		uint64_t x = 88172645463325252ull;
+		for (auto i=0; i<kN; ++i) Insert(m, static_cast<long>(Next(x) % kN));
+
+		x = 88172645463325252ull;
+		long sum = 0;
+		for (auto i=0; i<kN; ++i) sum += Lookup(m, static_cast<long>(Next(x) % kN));
+
+		for (auto i=0; i<kN / 64; ++i)
+		{
+			auto it = LowerBound(m, static_cast<long>(Next(x) % kN));
+			for (auto j=0; j<64 && it != m.end(); ++j, ++it) sum += (*it).second;
+		}
+		EXPECT_GT(sum, 0);
+	}
+}
+
+TEST(btree, bench_omem)
+{
+	Benchmark<omem::BTreeMap<long, long>>();
+}
+
+TEST(btree, bench_map)
+{
+	Benchmark<std::map<long, long>>();
+}
+
+TEST(btree, bench_map_omem)
+{
+	Benchmark<std::map<long, long, std::less<long>, PoolAllocator<std::pair<const long, long>>>>();
+}
@@ -0,0 +1,129 @@
+#include <memory>
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem/chunk.hpp>
+
+namespace
+{
+	class FailingResource final : public omem::ChunkResource
+	{
+	public:
+		explicit FailingResource(size_t budget) noexcept :budget_{budget} {}
+
+		void* Allocate(size_t size) override
+		{
+			if (budget_ == 0) throw std::bad_alloc{};
+			--budget_;
+			++live_;
+			return operator new(size);
+		}
+
+		void Deallocate(void* p, size_t) noexcept override
+		{
+			--live_;
+			operator delete(p);
+		}
+
+		size_t budget_;
+		size_t live_ = 0;
+	};
+
+	// Move-only, and counts the chunks it hands out.
+	struct OwningProvider
+	{
+		void* Allocate(size_t size)
+		{
+			++*live;
+			return operator new(size);
+		}
+
+		void Deallocate(void* p, size_t) noexcept
+		{
+			--*live;
+			operator delete(p);
+		}
+
+		std::unique_ptr<size_t> live = std::make_unique<size_t>(0);
+	};
+}
+
+TEST(chunk, move_only_provider)
+{
+	omem::BasicMemoryPool<OwningProvider> pool{16, 2};
+	auto* const live = pool.GetProvider().live.get();
+	EXPECT_EQ(*live, 1);
+	auto moved = std::move(pool);
+	EXPECT_EQ(moved.GetProvider().live.get(), live);
+	moved.Free(moved.Alloc());
+	pool = std::move(moved);
+	EXPECT_EQ(*live, 1);
+}
+
+TEST(chunk, failure_injection)
+{
+	FailingResource res{2};
+	{
+		omem::BasicMemoryPool<omem::AnyChunkProvider> pool{16, 2, res};
+		auto* a = pool.Alloc();
+		auto* b = pool.Alloc();
+		auto* c = pool.Alloc();
+		EXPECT_EQ(pool.GetInfo().fault, 1);
+		EXPECT_EQ(res.live_, 2);
+
+		EXPECT_THROW((void)pool.Alloc(), std::bad_alloc);
+		EXPECT_EQ(pool.GetInfo().cur, 3);
+		EXPECT_EQ(pool.GetInfo().fault, 1);
+
+		pool.Free(c);
+		pool.Free(b);
+		pool.Free(a);
+		EXPECT_EQ(res.live_, 1);
+	}
+	EXPECT_EQ(res.live_, 0);
+	EXPECT_THROW((omem::BasicMemoryPool<omem::AnyChunkProvider>{16, 2, res}), std::bad_alloc);
+}
+
+#if OMEM_HAS_POSIX
+TEST(chunk, mmap_manager)
+{
+	omem::BasicMemoryPoolManager<omem::MmapChunkProvider> manager;
+	std::vector<int*> v;
+	for (auto i=0; i<1000; ++i) v.push_back(manager.New<int>(i));
+	for (auto i=0; i<1000; ++i) EXPECT_EQ(*v[i], i);
+	for (auto* p : v) manager.Delete(p);
+}
+#endif
+
+TEST(chunk, region)
+{
+	std::vector<char> buf(OMEM_POOL_SIZE * 2);
+	auto* const region = buf.data();
+	omem::RegionChunkResource res{region, buf.size()};
+	omem::BasicMemoryPoolManager<omem::AnyChunkProvider> manager{res};
+	auto* const p = manager.Alloc(64);
+	EXPECT_GE(static_cast<char*>(p), region);
+	EXPECT_LT(static_cast<char*>(p), region + buf.size());
+	EXPECT_EQ(manager.Get(64).GetInfo().count * 64, res.GetUsed());
+	manager.Free(p, 64);
+}
+
+#ifdef MFD_CLOEXEC
+TEST(chunk, memfd)
+{
+	const auto fd = memfd_create("omem_test", MFD_CLOEXEC);
+	ASSERT_GE(fd, 0);
+	{
+		omem::FileChunkResource res{fd};
+		omem::BasicMemoryPool<omem::AnyChunkProvider> pool{64, 128, res};
+		auto* const p = static_cast<int*>(pool.Alloc());
+		*p = 7;
+		EXPECT_EQ(*p, 7);
+		pool.Free(p);
+	}
+	{
+		omem::FileChunkResource res{fd, 100};
+		EXPECT_THROW((void)res.Allocate(64), std::bad_alloc);
+	}
+	close(fd);
+}
+#endif
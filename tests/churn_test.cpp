@@ -0,0 +1,157 @@
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem/churn.hpp>
+
+namespace
+{
+	using Manager = omem::BasicMemoryPoolManager<omem::NewChunkProvider, omem::ChurnObserver>;
+
+	// The profile's hooks swallow their own failures, so observing doesn't cost the pool its noexcept.
+	static_assert(noexcept(std::declval<Manager::Pool&>().TryAlloc()));
+
+	const omem::ChurnSiteReport* Find(const std::vector<omem::ChurnSiteReport>& report, const char* site)
+	{
+		for (auto& r : report)
+			if (r.site && std::strcmp(r.site, site) == 0) return &r;
+		return nullptr;
+	}
+}
+
+TEST(churn, advice)
+{
+	auto& profile = omem::ChurnObserver::ThreadProfile();
+	profile = omem::ChurnProfile{1, 1000000};
+
+	omem::Config config;
+	config.Parse("pool_size:4k");
+	Manager manager{config};
+	void* p[16];
+	{
+		omem::ChurnSite site{"parse"};
+		for (auto i=0; i<100; ++i)
+		{
+			for (auto& x : p) x = manager.Alloc(24);
+			for (auto j=15; j>=0; --j) manager.Free(p[j], 24);
+		}
+	}
+	{
+		omem::ChurnSite site{"queue"};
+		for (auto i=0; i<100; ++i)
+		{
+			for (auto& x : p) x = manager.Alloc(48);
+			for (auto* x : p) manager.Free(x, 48);
+		}
+	}
+
+	std::vector<void*> kept(200);
+	{
+		omem::ChurnSite site{"cache"};
+		for (auto& x : kept) x = manager.Alloc(256);
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds{5});
+	for (auto* x : kept) manager.Free(x, 256);
+	manager.Free(manager.Alloc(8), 8);
+
+	const auto report = profile.Report();
+	ASSERT_EQ(report.size(), 4);
+	EXPECT_EQ(report[0].calls, 1600);
+
+	const auto* parse = Find(report, "parse");
+	ASSERT_TRUE(parse);
+	EXPECT_EQ(parse->size, 32);
+	EXPECT_EQ(parse->lifo_ratio, 1.0);
+	EXPECT_GE(parse->short_ratio, 0.5);
+	EXPECT_EQ(parse->advice, omem::ChurnAdvice::kArena);
+
+	const auto* queue = Find(report, "queue");
+	ASSERT_TRUE(queue);
+	EXPECT_LT(queue->lifo_ratio, 0.1);
+	EXPECT_GE(queue->short_ratio, 0.5);
+	EXPECT_EQ(queue->peak_live, 16);
+	EXPECT_EQ(queue->advice, omem::ChurnAdvice::kObjectPool);
+
+	const auto* cache = Find(report, "cache");
+	ASSERT_TRUE(cache);
+	EXPECT_LT(cache->short_ratio, 0.5);
+	EXPECT_DOUBLE_EQ(cache->fault_ratio, 0.92);
+	EXPECT_EQ(cache->advice, omem::ChurnAdvice::kPoolSize);
+	EXPECT_EQ(cache->suggested_pool_size, 65536);
+	EXPECT_EQ(cache->saved_ops, 184);
+
+	EXPECT_EQ(report[3].site, nullptr);
+	EXPECT_EQ(report[3].calls, 1);
+
+	auto* const file = std::tmpfile();
+	profile.Write(file);
+	std::string text(static_cast<size_t>(std::ftell(file)), '\0');
+	std::rewind(file);
+	text.resize(std::fread(text.data(), 1, text.size(), file));
+	std::fclose(file);
+	EXPECT_NE(text.find("arena, ~3200 manager calls saved"), std::string::npos);
+	EXPECT_NE(text.find("pool_size 65536, ~184 faults saved"), std::string::npos);
+	EXPECT_NE(text.find("(unnamed)"), std::string::npos);
+
+	profile.Reset();
+	EXPECT_TRUE(profile.Report().empty());
+}
+
+TEST(churn, sampling)
+{
+	auto& profile = omem::ChurnObserver::ThreadProfile();
+	profile = omem::ChurnProfile{8};
+	Manager manager;
+	std::vector<void*> p(1000);
+	for (auto& x : p) x = manager.Alloc(64);
+	for (auto* x : p) manager.Free(x, 64);
+
+	const auto report = profile.Report();
+	ASSERT_EQ(report.size(), 1);
+	EXPECT_EQ(report[0].calls, 1000);
+	EXPECT_EQ(report[0].peak_live, 1000);
+	profile.Reset();
+}
+
+TEST(churn, fifo)
+{
+	omem::ChurnProfile profile{1};
+	const omem::PoolInfo info{64, 0};
+	char blocks[10000];
+	for (size_t i=0; i<sizeof blocks; ++i)
+	{
+		profile.OnAlloc(info, blocks + i, false);
+		if (i >= 10) profile.OnFree(blocks + i - 10);
+	}
+	EXPECT_LE(profile.StackSize(), 2 * 10 + 64);
+
+	const auto report = profile.Report();
+	ASSERT_EQ(report.size(), 1);
+	EXPECT_EQ(report[0].lifo_ratio, 0);
+}
+
+template <class M>
+static void Benchmark()
+{
+	M manager;
+	void* p[64];
+	for (auto i=0; i<100000; ++i)
+	{
+		for (auto& x : p) x = manager.Alloc(32);
+		for (auto& x : p) manager.Free(x, 32);
+	}
+}
+
+TEST(churn, bench_null)
+{
+	Benchmark<omem::MemoryPoolManager>();
+}
+
+TEST(churn, bench_sampled)
+{
+	omem::ChurnObserver::ThreadProfile() = omem::ChurnProfile{};
+	Benchmark<Manager>();
+	omem::ChurnObserver::ThreadProfile().Reset();
+}
@@ -0,0 +1,95 @@
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem/compose.hpp>
+
+template <class A>
+static void Benchmark(A& al)
+{
+	size_t sizes[] = {8, 24, 40, 64, 100, 200, 700, 2000};
+	for (auto i=0; i<10000000; ++i)
+	{
+		const auto size = sizes[i % std::size(sizes)];
+		al.Free(al.Alloc(size), size);
+	}
+}
+
+using SmallPools = omem::Bucketizer<omem::PoolAllocator, 0, 256, 16>;
+using Composed = omem::Segregator<256,
+	omem::FallbackAllocator<SmallPools, omem::NewAllocator>,
+	omem::NewAllocator>;
+
+TEST(compose, segregator_fallback_bucketizer)
+{
+	Composed al{{SmallPools{2}, {}}, {}};
+
+	void* p[3];
+	for (auto& x : p) ASSERT_TRUE(x = al.Alloc(20));
+	EXPECT_TRUE(al.GetSmall().GetPrimary().Owns(p[0]));
+	EXPECT_TRUE(al.GetSmall().GetPrimary().Owns(p[1]));
+	EXPECT_FALSE(al.GetSmall().GetPrimary().Owns(p[2]));
+	EXPECT_EQ(al.GetSmall().GetPrimary().GetBucket(20).GetInfo().size, 32);
+	for (auto& x : p) al.Free(x, 20);
+	EXPECT_EQ(al.GetSmall().GetPrimary().GetBucket(20).GetInfo().cur, 0);
+
+	auto* const big = al.Alloc(1000);
+	ASSERT_TRUE(big);
+	al.Free(big, 1000);
+}
+
+TEST(compose, stats_affix)
+{
+	struct Header { size_t magic = 0xdeadbeef; };
+	struct Footer { unsigned tag = 42; };
+	omem::StatsCollector<omem::AffixAllocator<omem::NewAllocator, Header, Footer>> al;
+	using Affix = omem::AffixAllocator<omem::NewAllocator, Header, Footer>;
+
+	auto* const p = al.Alloc(13);
+	ASSERT_TRUE(p);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % alignof(std::max_align_t), 0);
+	EXPECT_EQ(Affix::GetPrefix(p).magic, 0xdeadbeef);
+	EXPECT_EQ(Affix::GetSuffix(p, 13).tag, 42);
+	EXPECT_EQ(al.GetStats().bytes, 13);
+	al.Free(p, 13);
+
+	EXPECT_EQ(al.GetStats().alloc, 1);
+	EXPECT_EQ(al.GetStats().free, 1);
+	EXPECT_EQ(al.GetStats().bytes, 0);
+	EXPECT_EQ(al.GetStats().peak_bytes, 13);
+}
+
+TEST(compose, nothrow_manager)
+{
+	omem::StatsCollector<omem::NothrowAllocator<>> al;
+	EXPECT_EQ(al.Alloc(SIZE_MAX), nullptr);
+	EXPECT_EQ(al.GetStats().failed, 1);
+
+	auto* const p = al.Alloc(24);
+	ASSERT_NE(p, nullptr);
+	al.Free(p, 24);
+	EXPECT_EQ(al.GetStats().bytes, 0);
+}
+
+TEST(compose, bench_composed)
+{
+	Composed al{{SmallPools{1024}, {}}, {}};
+	Benchmark(al);
+}
+
+TEST(compose, bench_stats_composed)
+{
+	omem::StatsCollector<Composed> al{Composed{{SmallPools{1024}, {}}, {}}};
+	Benchmark(al);
+	EXPECT_EQ(al.GetStats().bytes, 0);
+}
+
+TEST(compose, bench_manager)
+{
+	omem::MemoryPoolManager al;
+	Benchmark(al);
+}
+
+TEST(compose, bench_new)
+{
+	omem::NewAllocator al;
+	Benchmark(al);
+}
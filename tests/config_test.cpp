@@ -0,0 +1,71 @@
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <omem.hpp>
+
+TEST(config, parse)
+{
+	omem::Config config;
+	config.Parse("pool_size:64k, pool_size.24:4096\nmin_size:16 huge_pages:true stats:2");
+	EXPECT_EQ(config.pool_size, 64 << 10);
+	EXPECT_EQ(config.class_pool_size[5], 4096);
+	EXPECT_EQ(config.min_size, 16);
+	EXPECT_TRUE(config.huge_pages);
+	EXPECT_EQ(config.stats, 2);
+	EXPECT_EQ(config.PoolSize(5), 4096);
+	EXPECT_EQ(config.PoolSize(6), 64 << 10);
+
+	EXPECT_FALSE(config.Set("pool_size", "12x"));
+	EXPECT_FALSE(config.Set("unknown", "1"));
+	EXPECT_FALSE(config.Set("huge_pages", "maybe"));
+	config.Parse("bogus,pool_size:");
+	EXPECT_EQ(config.pool_size, 64 << 10);
+}
+
+TEST(config, overflow)
+{
+	omem::Config config;
+	EXPECT_FALSE(config.Set("pool_size.18446744073709551615", "1"));
+	EXPECT_TRUE(config.Set("pool_size.9223372036854775808", "1"));
+	EXPECT_EQ(config.class_pool_size[63], 1);
+	EXPECT_FALSE(config.Set("pool_size", "99999999999999999999"));
+	EXPECT_FALSE(config.Set("pool_size", "17179869184g"));
+	EXPECT_FALSE(config.Set("pool_size", "18446744073709551615"));
+	EXPECT_FALSE(config.Set("pool_size.64", "9223372036854775809"));
+	EXPECT_TRUE(config.Set("pool_size", "9223372036854775808"));
+	EXPECT_EQ(config.pool_size, size_t(1) << 63);
+	EXPECT_FALSE(config.Set("pool_size", "18446744073709551615"));
+	EXPECT_EQ(config.pool_size, size_t(1) << 63);
+	EXPECT_EQ(config.PoolSize(6), size_t(1) << 63);
+
+	omem::MemoryPoolManager manager;
+	EXPECT_EQ(manager.Alloc(SIZE_MAX, std::nothrow), nullptr);
+}
+
+TEST(config, manager)
+{
+	omem::Config config;
+	config.Parse("pool_size:4k,pool_size.64:256,min_size:32");
+	omem::MemoryPoolManager manager{config};
+
+	EXPECT_EQ(manager.Get(1).GetInfo().size, 32);
+	EXPECT_EQ(manager.Get(64).GetInfo().count, 4);
+	EXPECT_EQ(manager.Get(128).GetInfo().count, 32);
+}
+
+TEST(config, environment)
+{
+	const auto* path = "omem_config_test.conf";
+	auto* const file = std::fopen(path, "w");
+	ASSERT_TRUE(file);
+	std::fputs("# test\npool_size:2m\nstats:1\n", file);
+	for (auto i=0; i<1000; ++i) std::fputs("min_size:8\n", file);
+	std::fputs("latency_sample:7\n", file);
+	std::fclose(file);
+
+	const auto config = omem::Config::FromEnvironment(path, "stats:3");
+	std::remove(path);
+
+	EXPECT_EQ(config.pool_size, 2 << 20);
+	EXPECT_EQ(config.stats, 3);
+	EXPECT_EQ(config.latency_sample, 7);
+}
@@ -0,0 +1,133 @@
+#include <cstring>
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem/exec_pool.hpp>
+
+#if OMEM_HAS_POSIX && defined(__x86_64__)
+namespace
+{
+	// mov eax, imm32; ret
+	void EmitReturn(const omem::CodeBlock& b, int value)
+	{
+		auto* const p = static_cast<unsigned char*>(b.write);
+		p[0] = 0xB8;
+		std::memcpy(p + 1, &value, 4);
+		p[5] = 0xC3;
+	}
+
+	void CheckMode(omem::ExecMode mode)
+	{
+		omem::ExecutablePool pool{mode};
+		const auto a = pool.Alloc(6);
+		EXPECT_EQ(a.size, 16);
+		EmitReturn(a, 42);
+		pool.Seal();
+		EXPECT_EQ(a.As<int()>()(), 42);
+
+		const auto b = pool.Alloc(6);
+		EXPECT_NE(a.exec, b.exec);
+		EmitReturn(b, 7);
+		pool.Seal();
+		EXPECT_EQ(a.As<int()>()(), 42);
+		EXPECT_EQ(b.As<int()>()(), 7);
+
+		pool.Free(a);
+		const auto c = pool.Alloc(10);
+		EXPECT_EQ(c.exec, a.exec);
+		EmitReturn(c, 9);
+		pool.Seal();
+		EXPECT_EQ(c.As<int()>()(), 9);
+
+		const auto big = pool.Alloc(10000);
+		EmitReturn(big, 5);
+		pool.Seal();
+		EXPECT_EQ(big.As<int()>()(), 5);
+		pool.Free(big);
+		EXPECT_EQ(pool.GetReserved(), 256 << 10);
+	}
+}
+
+TEST(exec_pool, dual_map)
+{
+	omem::ExecutablePool pool;
+	if (pool.GetMode() != omem::ExecMode::kDualMap) GTEST_SKIP();
+	CheckMode(omem::ExecMode::kDualMap);
+
+	const auto b = pool.Alloc(16);
+	EXPECT_NE(b.write, b.exec);
+	EXPECT_DEATH(*static_cast<volatile char*>(const_cast<void*>(b.exec)) = 0, "");
+}
+
+TEST(exec_pool, mprotect)
+{
+	CheckMode(omem::ExecMode::kMprotect);
+}
+
+namespace
+{
+	constexpr auto kFunctions = 20000;
+
+	template <class Compile>
+	void Benchmark(Compile&& compile)
+	{
+		long sum = 0;
+		for (auto r=0; r<5; ++r)
+		{
+			for (auto i=0; i<kFunctions; ++i) sum += compile(i);
+		}
+		EXPECT_EQ(sum, 5l * kFunctions * (kFunctions - 1) / 2);
+	}
+}
+
+TEST(exec_pool, bench_mmap)
+{
+	std::vector<void*> code(kFunctions);
+	Benchmark([&](int i)
+	{
+		const auto page = omem::PageSize();
+		auto* const p = mmap(nullptr, page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		EmitReturn({p, p, page}, i);
+		mprotect(p, page, PROT_READ | PROT_EXEC);
+		const auto ret = reinterpret_cast<int(*)()>(p)();
+		munmap(p, page);
+		return ret;
+	});
+}
+
+TEST(exec_pool, bench_dual_map)
+{
+	omem::ExecutablePool pool{omem::ExecMode::kDualMap};
+	Benchmark([&](int i)
+	{
+		const auto b = pool.Alloc(6);
+		EmitReturn(b, i);
+		pool.Seal();
+		const auto ret = b.As<int()>()();
+		pool.Free(b);
+		return ret;
+	});
+}
+
+// Compiles a batch of functions, seals once, then runs and frees them.
+TEST(exec_pool, bench_mprotect_batched)
+{
+	omem::ExecutablePool pool{omem::ExecMode::kMprotect};
+	std::vector<omem::CodeBlock> code(1000);
+	Benchmark([&](int i)
+	{
+		const auto slot = size_t(i) % code.size();
+		code[slot] = pool.Alloc(6);
+		EmitReturn(code[slot], i);
+		if (slot != code.size() - 1 && i != kFunctions - 1) return 0;
+
+		pool.Seal();
+		auto ret = 0;
+		for (size_t j=0; j<=slot; ++j)
+		{
+			ret += code[j].As<int()>()();
+			pool.Free(code[j]);
+		}
+		return ret;
+	});
+}
+#endif
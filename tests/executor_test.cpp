@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <future>
+#include <random>
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include <omem/executor.hpp>
+
+static constexpr int kFibN = 30;
+static constexpr int kFibCutoff = 16;
+static constexpr size_t kSortN = 1 << 20;
+static constexpr size_t kSortCutoff = 1 << 12;
+
+static int SerialFib(int n)
+{
+	return n < 2 ? n : SerialFib(n - 1) + SerialFib(n - 2);
+}
+
+static int Fib(omem::Executor& ex, int n)
+{
+	if (n < kFibCutoff) return SerialFib(n);
+	int a, b;
+	omem::TaskGroup g{ex};
+	g.Run([&] { a = Fib(ex, n - 1); });
+	b = Fib(ex, n - 2);
+	g.Wait();
+	return a + b;
+}
+
+static int AsyncFib(int n)
+{
+	if (n < kFibCutoff) return SerialFib(n);
+	auto a = std::async(std::launch::async, AsyncFib, n - 1);
+	const auto b = AsyncFib(n - 2);
+	return a.get() + b;
+}
+
+// Three-way partition; returns the range of elements equal to the pivot.
+template <class It>
+static std::pair<It, It> Partition(It first, It last)
+{
+	const auto pivot = *(first + (last - first) / 2);
+	const auto mid = std::partition(first, last, [pivot](auto x) { return x < pivot; });
+	return {mid, std::partition(mid, last, [pivot](auto x) { return !(pivot < x); })};
+}
+
+template <class It>
+static void Sort(omem::Executor& ex, It first, It last)
+{
+	if (static_cast<size_t>(last - first) < kSortCutoff) return std::sort(first, last);
+	const auto [mid, mid2] = Partition(first, last);
+	omem::TaskGroup g{ex};
+	g.Run([&, mid = mid] { Sort(ex, first, mid); });
+	Sort(ex, mid2, last);
+	g.Wait();
+}
+
+template <class It>
+static void AsyncSort(It first, It last)
+{
+	if (static_cast<size_t>(last - first) < kSortCutoff) return std::sort(first, last);
+	const auto [mid, mid2] = Partition(first, last);
+	auto f = std::async(std::launch::async, [first, mid = mid] { AsyncSort(first, mid); });
+	AsyncSort(mid2, last);
+	f.get();
+}
+
+static std::vector<int> RandomInts()
+{
+	std::vector<int> v(kSortN);
+	std::mt19937 rng{42};
+	for (auto& x : v) x = static_cast<int>(rng());
+	return v;
+}
+
+TEST(executor, deque)
+{
+	omem::WorkStealingDeque<int> d{2};
+	int x[5];
+	for (auto& i : x) d.Push(&i);
+	EXPECT_EQ(d.Steal(), &x[0]);
+	EXPECT_EQ(d.Take(), &x[4]);
+	EXPECT_EQ(d.Take(), &x[3]);
+	EXPECT_EQ(d.Steal(), &x[1]);
+	EXPECT_EQ(d.Take(), &x[2]);
+	EXPECT_EQ(d.Take(), nullptr);
+	EXPECT_EQ(d.Steal(), nullptr);
+	EXPECT_TRUE(d.Empty());
+}
+
+TEST(executor, spawn_from_outside)
+{
+	std::atomic<int> sum{0};
+	{
+		omem::Executor ex{4};
+		for (auto i=1; i<=1000; ++i) ex.Spawn([&sum, i] { sum += i; });
+	}
+	EXPECT_EQ(sum, 500500);
+}
+
+TEST(executor, throwing_task)
+{
+	struct Throwing
+	{
+		Throwing() = default;
+		Throwing(const Throwing&) { throw std::runtime_error{"copy"}; }
+		void operator()() const noexcept {}
+	};
+
+	omem::Executor ex{2};
+	const Throwing f;
+	EXPECT_THROW(ex.Spawn(f), std::runtime_error);
+	omem::TaskGroup g{ex};
+	EXPECT_THROW(g.Run(f), std::runtime_error);
+}
+
+TEST(executor, bench_fib)
+{
+	omem::Executor ex;
+	int result = 0;
+	{
+		omem::TaskGroup g{ex};
+		g.Run([&] { result = Fib(ex, kFibN); });
+	}
+	EXPECT_EQ(result, SerialFib(kFibN));
+}
+
+TEST(executor, bench_fib_async)
+{
+	EXPECT_EQ(AsyncFib(kFibN), SerialFib(kFibN));
+}
+
+TEST(executor, bench_sort)
+{
+	auto v = RandomInts();
+	{
+		omem::Executor ex;
+		omem::TaskGroup g{ex};
+		g.Run([&] { Sort(ex, v.begin(), v.end()); });
+	}
+	EXPECT_TRUE(std::is_sorted(v.begin(), v.end()));
+}
+
+TEST(executor, bench_sort_async)
+{
+	auto v = RandomInts();
+	AsyncSort(v.begin(), v.end());
+	EXPECT_TRUE(std::is_sorted(v.begin(), v.end()));
+}
@@ -0,0 +1,83 @@
+#include <array>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem/function.hpp>
+
+TEST(function, inline_and_spilled)
+{
+	using Fn = omem::Function<int(int)>;
+	auto small = [k = 3](int x) { return x * k; };
+	auto big = [k = std::array<int, 16>{4}](int x) { return x * k[0]; };
+	static_assert(Fn::IsInline<decltype(small)>());
+	static_assert(!Fn::IsInline<decltype(big)>());
+
+	Fn f{small}, g{big};
+	EXPECT_EQ(f(2), 6);
+	EXPECT_EQ(g(2), 8);
+	f.swap(g);
+	EXPECT_EQ(f(2), 8);
+	EXPECT_EQ(g(2), 6);
+
+	const auto cur = omem::ThreadPools().Get(sizeof(big)).GetInfo().cur;
+	Fn h{std::move(f)};
+	EXPECT_FALSE(f);
+	EXPECT_EQ(h(1), 4);
+	h = nullptr;
+	EXPECT_EQ(omem::ThreadPools().Get(sizeof(big)).GetInfo().cur, cur - 1);
+}
+
+TEST(function, move_only)
+{
+	omem::Function<int()> f{[p = std::make_unique<int>(5)] { return *p; }};
+	EXPECT_EQ(f(), 5);
+
+	auto shared = std::make_shared<int>(7);
+	{
+		omem::Function<int(), 8> g{[shared, pad = std::array<char, 32>{}] { return *shared; }};
+		EXPECT_EQ(shared.use_count(), 2);
+		f = std::move(g);
+	}
+	EXPECT_EQ(f(), 7);
+	EXPECT_EQ(shared.use_count(), 2);
+	f = {};
+	EXPECT_EQ(shared.use_count(), 1);
+}
+
+template <template <class> class Fn>
+static void Benchmark()
+{
+	std::vector<Fn<void(long&)>> handlers;
+	handlers.reserve(64);
+	long sum = 0;
+	for (auto i=0; i<100000; ++i)
+	{
+		for (long j=0; j<64; ++j)
+			handlers.emplace_back([j, a = j * 2, b = j * 3, c = j * 4, d = j * 5](long& out) { out += j + a + b + c + d; });
+		for (auto& h : handlers) h(sum);
+		handlers.clear();
+	}
+	EXPECT_EQ(sum, 100000L * 15 * (63 * 64 / 2));
+}
+
+template <class Sig>
+using OmemFunction = omem::Function<Sig, 48>;
+
+template <class Sig>
+using SmallOmemFunction = omem::Function<Sig, 16>;
+
+TEST(function, bench_omem_inline)
+{
+	Benchmark<OmemFunction>();
+}
+
+TEST(function, bench_omem_spilled)
+{
+	Benchmark<SmallOmemFunction>();
+}
+
+TEST(function, bench_std)
+{
+	Benchmark<std::function>();
+}
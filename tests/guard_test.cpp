@@ -0,0 +1,165 @@
+#include <cstring>
+#include <gtest/gtest.h>
+#include <omem.hpp>
+
+#if OMEM_HAS_GUARD
+#include <csetjmp>
+#include <csignal>
+#include <unistd.h>
+
+namespace
+{
+	omem::Config GuardAll()
+	{
+		omem::Config config;
+		config.Parse("guard_sample:1,guard_slots:16");
+		return config;
+	}
+}
+
+TEST(guard, sample)
+{
+	omem::MemoryPoolManager manager{GuardAll()};
+	auto* const p = static_cast<char*>(manager.Alloc(24));
+	EXPECT_TRUE(omem::IsGuarded(p));
+	std::memset(p, 1, 24);
+	EXPECT_EQ(manager.Get(24).GetInfo().cur, 0);
+
+	auto* const q = static_cast<char*>(manager.Realloc(p, 24, 100));
+	EXPECT_TRUE(omem::IsGuarded(q));
+	EXPECT_EQ(q[23], 1);
+	manager.Free(q, 100);
+
+	auto* const big = manager.Alloc(1 << 20);
+	EXPECT_FALSE(omem::IsGuarded(big));
+	manager.Free(big, 1 << 20);
+
+	omem::MemoryPoolManager plain{omem::Config{}};
+	auto* const r = plain.Alloc(24);
+	EXPECT_FALSE(omem::IsGuarded(r));
+	plain.Free(r, 24);
+}
+
+TEST(guard, rate)
+{
+	omem::Config config;
+	config.Parse("guard_sample:10,guard_slots:16");
+	omem::MemoryPoolManager manager{config};
+	void* p[100];
+	auto guarded = 0;
+	for (auto& x : p) guarded += omem::IsGuarded(x = manager.Alloc(32));
+	EXPECT_EQ(guarded, 10);
+	for (auto* x : p) manager.Free(x, 32);
+}
+
+TEST(guard, release)
+{
+	struct sigaction before{};
+	sigaction(SIGSEGV, nullptr, &before);
+
+	void* p;
+	{
+		omem::MemoryPoolManager a{GuardAll()};
+		{
+			omem::MemoryPoolManager b{GuardAll()};
+			p = b.Alloc(32);
+		}
+		EXPECT_TRUE(omem::IsGuarded(p));
+		a.Free(p, 32);
+	}
+	EXPECT_FALSE(omem::IsGuarded(p));
+	struct sigaction after{};
+	sigaction(SIGSEGV, nullptr, &after);
+	EXPECT_EQ(after.sa_handler, before.sa_handler);
+
+	// A block still live when the last manager goes away keeps the region mapped.
+	{
+		omem::MemoryPoolManager a{GuardAll()};
+		p = a.Alloc(32);
+	}
+	EXPECT_TRUE(omem::IsGuarded(p));
+	omem::MemoryPoolManager a{GuardAll()};
+	a.Free(p, 32);
+}
+
+TEST(guard, overflow)
+{
+	omem::MemoryPoolManager manager{GuardAll()};
+	auto* const p = static_cast<volatile char*>(manager.Alloc(32));
+	EXPECT_DEATH(p[32] = 1, "buffer overflow");
+	manager.Free(const_cast<char*>(p), 32);
+}
+
+TEST(guard, use_after_free)
+{
+	omem::MemoryPoolManager manager{GuardAll()};
+	auto* const p = static_cast<volatile char*>(manager.Alloc(32));
+	manager.Free(const_cast<char*>(p), 32);
+	EXPECT_DEATH((void)p[0], "use-after-free");
+}
+
+namespace
+{
+	sigjmp_buf recover;
+	int other_faults = 0;
+
+	// Recovers from the first fault and exits on the next.
+	void OnOtherFault(int)
+	{
+		if (other_faults++ == 0) siglongjmp(recover, 1);
+		_exit(3);
+	}
+}
+
+// Faults outside the region go to the handler it replaced, and the region keeps reporting
+// afterwards. Runs in a fresh process so that the region is created after OnOtherFault is installed.
+TEST(guard, chain)
+{
+	const auto style = testing::GTEST_FLAG(death_test_style);
+	testing::GTEST_FLAG(death_test_style) = "threadsafe";
+	EXPECT_EXIT(
+	{
+		signal(SIGSEGV, &OnOtherFault);
+		omem::MemoryPoolManager manager{GuardAll()};
+		auto* const p = static_cast<volatile char*>(manager.Alloc(32));
+		volatile uintptr_t wild = 16;
+		if (!sigsetjmp(recover, 1)) *reinterpret_cast<volatile char*>(wild) = 1;
+		p[32] = 1;
+	}, testing::ExitedWithCode(3), "buffer overflow");
+	testing::GTEST_FLAG(death_test_style) = style;
+}
+
+TEST(guard, double_free)
+{
+	omem::MemoryPoolManager manager{GuardAll()};
+	auto* const p = manager.Alloc(32);
+	manager.Free(p, 32);
+	EXPECT_DEATH(manager.Free(p, 32), "double free");
+}
+#endif
+
+static void Benchmark(omem::MemoryPoolManager& manager)
+{
+	void* p[64];
+	for (auto i=0; i<200000; ++i)
+	{
+		for (auto& x : p) x = manager.Alloc(48);
+		for (auto& x : p) manager.Free(x, 48);
+	}
+}
+
+// The shipped default: sampling is off (guard_sample:0).
+TEST(guard, bench_off)
+{
+	omem::MemoryPoolManager manager{omem::Config{}};
+	Benchmark(manager);
+}
+
+// One in 4096 allocations guarded, the rate the README recommends for production.
+TEST(guard, bench_sampled)
+{
+	omem::Config config;
+	config.guard_sample = 4096;
+	omem::MemoryPoolManager manager{config};
+	Benchmark(manager);
+}
@@ -0,0 +1,116 @@
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem/intern.hpp>
+
+static std::vector<std::string> Identifiers(size_t unique, size_t total)
+{
+	std::vector<std::string> v;
+	v.reserve(total);
+	uint64_t x = 88172645463325252ull;
+	for (size_t i=0; i<total; ++i)
+	{
+		x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+		v.push_back("column_" + std::to_string(x % unique) + "_id");
+	}
+	return v;
+}
+
+TEST(intern, basic)
+{
+	omem::InternPool pool{64};
+	const auto a = pool.Intern("alpha");
+	const auto b = pool.Intern("beta");
+	EXPECT_NE(a, b);
+	EXPECT_EQ(pool.Intern(std::string{"alpha"}), a);
+	EXPECT_EQ(pool[a], "alpha");
+	EXPECT_EQ(pool.Intern(""), pool.Intern(""));
+	EXPECT_FALSE(pool.Find("gamma"));
+
+	const std::string big(100, 'x');
+	const auto view = pool.InternView(big);
+	EXPECT_EQ(view, big);
+
+	std::vector<std::string_view> views;
+	for (auto i=0; i<10000; ++i) views.push_back(pool.InternView(std::to_string(i)));
+	for (auto i=0; i<10000; ++i) EXPECT_EQ(views[i], std::to_string(i));
+	EXPECT_EQ(pool.InternView(big).data(), view.data());
+	EXPECT_EQ(*pool.Find("1234"), pool.Intern("1234"));
+	EXPECT_EQ(pool.Size(), 10004);
+
+	// Only the length is looked at, so the view never has to be backed by memory.
+	EXPECT_THROW((void)pool.Intern({big.data(), size_t(1) << 32}), std::bad_alloc);
+	EXPECT_EQ(pool.Size(), 10004);
+}
+
+namespace
+{
+	size_t std_bytes = 0;
+
+	template <class T>
+	struct CountingAllocator
+	{
+		using value_type = T;
+
+		CountingAllocator() = default;
+		template <class U> CountingAllocator(const CountingAllocator<U>&) noexcept {}
+
+		T* allocate(size_t n)
+		{
+			std_bytes += n * sizeof(T);
+			return std::allocator<T>{}.allocate(n);
+		}
+
+		void deallocate(T* p, size_t n) noexcept
+		{
+			std_bytes -= n * sizeof(T);
+			std::allocator<T>{}.deallocate(p, n);
+		}
+
+		template <class U> bool operator==(const CountingAllocator<U>&) const noexcept { return true; }
+		template <class U> bool operator!=(const CountingAllocator<U>&) const noexcept { return false; }
+	};
+
+	using String = std::basic_string<char, std::char_traits<char>, CountingAllocator<char>>;
+	struct StringHash
+	{
+		size_t operator()(const String& s) const noexcept { return std::hash<std::string_view>{}({s.data(), s.size()}); }
+	};
+
+	using StdSet = std::unordered_set<String, StringHash, std::equal_to<String>, CountingAllocator<String>>;
+
+	const auto ids = Identifiers(100000, 1000000);
+}
+
+TEST(intern, bench_omem)
+{
+	omem::InternPool pool;
+	size_t sum = 0;
+	for (auto& s : ids) sum += pool.Intern(s);
+	for (auto& s : ids) sum += *pool.Find(s);
+	EXPECT_GT(sum, 0);
+}
+
+TEST(intern, bench_std)
+{
+	StdSet set;
+	size_t sum = 0;
+	for (auto& s : ids) sum += set.emplace(s.data(), s.size()).first->size();
+	for (auto& s : ids) sum += set.find(String{s.data(), s.size()})->size();
+	EXPECT_GT(sum, 0);
+}
+
+TEST(intern, memory)
+{
+	omem::InternPool pool;
+	StdSet set;
+	for (auto& s : ids)
+	{
+		(void)pool.Intern(s);
+		set.emplace(s.data(), s.size());
+	}
+	RecordProperty("omem_bytes", static_cast<int>(pool.MemoryUsage()));
+	RecordProperty("std_bytes", static_cast<int>(std_bytes));
+	EXPECT_LT(pool.MemoryUsage(), std_bytes);
+}
@@ -0,0 +1,67 @@
+#include <thread>
+#include <gtest/gtest.h>
+#include <omem.hpp>
+
+TEST(latency, buckets)
+{
+	using H = omem::LatencyHistogram;
+	for (uint64_t v : {0ull, 1ull, 7ull, 8ull, 9ull, 15ull, 16ull, 100ull, 12345ull, ~0ull})
+	{
+		const auto b = H::BucketOf(v);
+		ASSERT_LT(b, H::kBuckets);
+		EXPECT_LE(H::BucketLower(b), v);
+		if (b + 1 < H::kBuckets)
+		{
+			EXPECT_GT(H::BucketLower(b + 1), v);
+		}
+	}
+
+	H h;
+	for (uint64_t v=1; v<=1000; ++v) h.Record(v);
+	EXPECT_EQ(h.Count(), 1000);
+	EXPECT_LE(h.Percentile(0.5), 500);
+	EXPECT_GE(h.Percentile(0.5), 500 * 7 / 8);
+	EXPECT_GE(h.Percentile(1), 896);
+}
+
+TEST(latency, sampling)
+{
+	omem::Config config;
+	config.Parse("stats:2,latency_sample:1,pool_size:64");
+	const auto before = omem::GetLatencyStats();
+
+	std::thread{[&]
+	{
+		omem::MemoryPoolManager manager{config};
+		void* p[16];
+		for (auto& x : p) x = manager.Alloc(8);
+		for (auto& x : p) manager.Free(x, 8);
+	}}.join();
+
+	const auto after = omem::GetLatencyStats();
+	EXPECT_EQ(after.alloc.Count() - before.alloc.Count(), 8);
+	EXPECT_EQ(after.fault.Count() - before.fault.Count(), 8);
+	EXPECT_EQ(after.free.Count() - before.free.Count(), 16);
+}
+
+static void Benchmark(omem::MemoryPoolManager& manager)
+{
+	for (auto i=0; i<10000000; ++i)
+		manager.Free(manager.Alloc(8), 8);
+}
+
+TEST(latency, bench_off)
+{
+	omem::MemoryPoolManager manager{omem::Config{}};
+	Benchmark(manager);
+}
+
+TEST(latency, bench_sampled)
+{
+	omem::Config config;
+	config.stats = 2;
+	omem::MemoryPoolManager manager{config};
+	const auto before = omem::GetLatencyStats().alloc.Count();
+	Benchmark(manager);
+	EXPECT_GT(omem::GetLatencyStats().alloc.Count(), before);
+}
@@ -0,0 +1,97 @@
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <gtest/gtest.h>
+#include <omem/lru.hpp>
+
+TEST(lru, eviction)
+{
+	omem::LruCache<int, std::string> cache{3};
+	cache.Put(1, "one");
+	cache.Put(2, "two");
+	cache.Put(3, "three");
+	ASSERT_TRUE(cache.Get(1));
+	cache.Put(4, "four");
+
+	EXPECT_FALSE(cache.Peek(2));
+	EXPECT_EQ(*cache.Peek(1), "one");
+	EXPECT_EQ(cache.Size(), 3);
+	EXPECT_EQ(cache.GetInfo().fault, 0);
+	EXPECT_EQ(cache.GetInfo().cur, 3);
+
+	cache.Put(3, "THREE");
+	std::string order;
+	cache.ForEach([&](int k, const std::string&) { order += std::to_string(k); });
+	EXPECT_EQ(order, "341");
+
+	EXPECT_TRUE(cache.Erase(4));
+	EXPECT_FALSE(cache.Erase(4));
+	EXPECT_EQ(cache.GetInfo().cur, 2);
+	cache.Clear();
+	EXPECT_EQ(cache.Size(), 0);
+	EXPECT_EQ(cache.GetInfo().cur, 0);
+}
+
+namespace
+{
+	class StdLru
+	{
+	public:
+		explicit StdLru(size_t capacity) :capacity_{capacity} {}
+
+		long* Get(long key)
+		{
+			const auto it = map_.find(key);
+			if (it == map_.end()) return nullptr;
+			list_.splice(list_.begin(), list_, it->second);
+			return &it->second->second;
+		}
+
+		void Put(long key, long value)
+		{
+			if (auto* v = Get(key))
+			{
+				*v = value;
+				return;
+			}
+			if (map_.size() == capacity_)
+			{
+				map_.erase(list_.back().first);
+				list_.pop_back();
+			}
+			list_.emplace_front(key, value);
+			map_.emplace(key, list_.begin());
+		}
+
+	private:
+		size_t capacity_;
+		std::list<std::pair<long, long>> list_;
+		std::unordered_map<long, std::list<std::pair<long, long>>::iterator> map_;
+	};
+}
+
+template <class Cache>
+static void Benchmark()
+{
+	Cache cache{4096};
+	uint64_t x = 88172645463325252ull;
+	long hits = 0;
+	for (auto i=0; i<5000000; ++i)
+	{
+		x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+		const auto key = static_cast<long>(x % 16384);
+		if (auto* v = cache.Get(key)) hits += *v == key;
+		else cache.Put(key, key);
+	}
+	EXPECT_GT(hits, 0);
+}
+
+TEST(lru, bench_omem)
+{
+	Benchmark<omem::LruCache<long, long>>();
+}
+
+TEST(lru, bench_std)
+{
+	Benchmark<StdLru>();
+}
@@ -0,0 +1,123 @@
+#include <cstring>
+#include <new>
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem/mesh.hpp>
+
+#ifdef __linux__
+TEST(mesh, basic)
+{
+	omem::MeshingPool pool{64};
+	const auto slots = omem::PageSize() / 64;
+
+	std::vector<void*> p(slots * 2);
+	for (auto& x : p) std::memset(x = pool.Alloc(), 1, 64);
+	EXPECT_EQ(pool.PhysicalBytes(), 2 * omem::PageSize());
+	EXPECT_EQ(pool.Mesh(), 0);
+
+	for (size_t i=0; i<slots; ++i) pool.Free(p[i]);
+	EXPECT_EQ(pool.PhysicalBytes(), omem::PageSize());
+	EXPECT_EQ(pool.GetLive(), slots);
+
+	for (size_t i=0; i<slots; ++i) p[i] = pool.Alloc();
+	for (auto* x : p) pool.Free(x);
+	EXPECT_EQ(pool.GetLive(), 0);
+}
+
+TEST(mesh, disjoint)
+{
+	omem::MeshingPool pool{64};
+	const auto slots = omem::PageSize() / 64;
+
+	std::vector<char*> p(slots * 2);
+	for (auto& x : p) x = static_cast<char*>(pool.Alloc());
+	for (size_t i=0; i<p.size(); ++i) std::memset(p[i], static_cast<int>(i), 64);
+	auto* const second = p[slots];
+
+	// Keep even slots of the first page and odd slots of the second.
+	for (size_t i=0; i<p.size(); ++i)
+	{
+		if ((i < slots) == (i % 2 == 0)) continue;
+		pool.Free(p[i]);
+		p[i] = nullptr;
+	}
+
+	EXPECT_EQ(pool.Mesh(), omem::PageSize());
+	EXPECT_EQ(pool.PhysicalBytes(), omem::PageSize());
+	for (size_t i=0; i<p.size(); ++i)
+	{
+		if (p[i])
+		{
+			ASSERT_EQ(p[i][63], static_cast<char>(i));
+		}
+	}
+
+	// The two views now share memory.
+	p[0][0] = 'x';
+	EXPECT_EQ(second[0], 'x');
+
+	auto* const q = static_cast<char*>(pool.Alloc());
+	*q = 1;
+	EXPECT_EQ(pool.PhysicalBytes(), omem::PageSize() * 2);
+	pool.Free(q);
+	for (auto* x : p) if (x) pool.Free(x);
+	EXPECT_EQ(pool.GetLive(), 0);
+}
+
+TEST(mesh, exhausted)
+{
+	omem::MeshingPool pool{64, 2};
+	const auto slots = omem::PageSize() / 64;
+
+	std::vector<void*> p(slots * 2);
+	for (auto& x : p) x = pool.Alloc();
+	const auto physical = pool.PhysicalBytes();
+	EXPECT_THROW((void)pool.Alloc(), std::bad_alloc);
+	EXPECT_THROW((void)pool.Alloc(), std::bad_alloc);
+	EXPECT_EQ(pool.PhysicalBytes(), physical);
+
+	pool.Free(p[0]);
+	EXPECT_EQ(pool.Alloc(), p[0]);
+	for (auto* x : p) pool.Free(x);
+	EXPECT_EQ(pool.GetLive(), 0);
+	for (auto& x : p) x = pool.Alloc();
+	for (auto* x : p) pool.Free(x);
+}
+
+// Fills many pages, frees most objects at random and meshes until nothing more can be reclaimed.
+TEST(mesh, bench_fragmentation)
+{
+	constexpr size_t kObjects = 1 << 18;
+	omem::MeshingPool pool{64};
+	std::vector<uint64_t*> p(kObjects);
+	for (size_t i=0; i<kObjects; ++i)
+	{
+		p[i] = static_cast<uint64_t*>(pool.Alloc());
+		*p[i] = i;
+	}
+
+	uint64_t x = 88172645463325252ull;
+	for (auto& q : p)
+	{
+		x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+		if (x % 10 == 0) continue;
+		pool.Free(q);
+		q = nullptr;
+	}
+
+	const auto before = pool.PhysicalBytes();
+	while (pool.Mesh()) {}
+	const auto after = pool.PhysicalBytes();
+	RecordProperty("before_bytes", static_cast<int>(before));
+	RecordProperty("after_bytes", static_cast<int>(after));
+	EXPECT_LT(after * 2, before);
+
+	for (size_t i=0; i<kObjects; ++i)
+	{
+		if (p[i])
+		{
+			ASSERT_EQ(*p[i], i);
+		}
+	}
+}
+#endif
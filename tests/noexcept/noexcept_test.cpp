@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <omem.hpp>
+#include <omem/arena.hpp>
+#include <omem/btree.hpp>
+#include <omem/churn.hpp>
+#include <omem/compose.hpp>
+#include <omem/exec_pool.hpp>
+#include <omem/executor.hpp>
+#include <omem/function.hpp>
+#include <omem/intern.hpp>
+#include <omem/lru.hpp>
+#include <omem/mesh.hpp>
+#include <omem/observer.hpp>
+#include <omem/pressure.hpp>
+#include <omem/rc.hpp>
+#include <omem/segmented_vector.hpp>
+#include <omem/soa.hpp>
+#include <omem/stack_pool.hpp>
+#include <omem/timeline.hpp>
+#include <omem/vector.hpp>
+
+// Built with -fno-exceptions: every header has to compile, and failures come back as nullptr.
+#ifndef OMEM_NO_EXCEPTIONS
+#error "expected OMEM_NO_EXCEPTIONS to be detected"
+#endif
+
+int main(int argc, char* argv[])
+{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+namespace
+{
+	struct BudgetProvider
+	{
+		void* Allocate(size_t size) noexcept
+		{
+			if (*budget == 0) return nullptr;
+			--*budget;
+			return operator new(size, std::nothrow);
+		}
+
+		void Deallocate(void* p, size_t) noexcept { operator delete(p); }
+
+		size_t* budget;
+	};
+
+	struct Pair
+	{
+		long a;
+		long b;
+	};
+}
+
+TEST(noexcept, pool)
+{
+	size_t budget = 0;
+	omem::BasicMemoryPool<BudgetProvider> pool{16, 2, {&budget}};
+	EXPECT_EQ(pool.Alloc(std::nothrow), nullptr);
+	EXPECT_DEATH((void)pool.Alloc(), "Out of memory");
+
+	budget = 2;
+	auto* const a = pool.Alloc(std::nothrow);
+	auto* const b = pool.Alloc(std::nothrow);
+	auto* const c = pool.Alloc(std::nothrow);
+	ASSERT_TRUE(a && b && c);
+	EXPECT_TRUE(pool.Owns(a));
+	EXPECT_FALSE(pool.Owns(c));
+	EXPECT_EQ(pool.Alloc(std::nothrow), nullptr);
+	EXPECT_EQ(pool.GetInfo().fault, 1);
+	pool.Free(a);
+	pool.Free(b);
+	pool.Free(c);
+}
+
+TEST(noexcept, manager)
+{
+	size_t budget = 0;
+	omem::BasicMemoryPoolManager<BudgetProvider> manager{BudgetProvider{&budget}};
+	EXPECT_EQ(manager.New<Pair>(std::nothrow, 1l, 2l), nullptr);
+	EXPECT_EQ(manager.NewArr<Pair>(std::nothrow, 3), nullptr);
+
+	budget = 1;
+	EXPECT_EQ(manager.Alloc(SIZE_MAX, std::nothrow), nullptr);
+	EXPECT_EQ(manager.Alloc((size_t(1) << 63) + 1, std::nothrow), nullptr);
+	EXPECT_EQ(manager.NewArr<Pair>(std::nothrow, SIZE_MAX / 8), nullptr);
+	EXPECT_EQ(manager.NewArr<Pair>(std::nothrow, SIZE_MAX / 16 + 1), nullptr);
+	EXPECT_EQ(budget, 1);
+
+	budget = 1;
+	auto* const p = manager.New<Pair>(std::nothrow, 1l, 2l);
+	ASSERT_TRUE(p);
+	EXPECT_EQ(p->b, 2);
+	manager.Delete(p);
+	static_assert(noexcept(manager.Alloc(16, std::nothrow)));
+}
+
+TEST(noexcept, containers)
+{
+	omem::LruCache<int, int> lru{4};
+	lru.Put(1, 10);
+	EXPECT_EQ(*lru.Get(1), 10);
+
+	auto rc = omem::MakeRc<Pair>(Pair{3, 4});
+	EXPECT_EQ(rc->b, 4);
+
+	long big[8] = {5};
+	omem::Function<long()> f{[big] { return big[0]; }};
+	EXPECT_EQ(f(), 5);
+
+	omem::Vector<int> v;
+	for (auto i=0; i<100; ++i) v.PushBack(i);
+	EXPECT_EQ(v[99], 99);
+}
+
+// Same loop as nothrow.bench_new_delete in the regular build.
+TEST(noexcept, bench_new_delete)
+{
+	omem::MemoryPoolManager manager;
+	Pair* p[64];
+	long sum = 0;
+	for (auto i=0; i<200000; ++i)
+	{
+		for (auto& x : p) x = manager.New<Pair>(std::nothrow, long{i}, 1l);
+		for (auto* x : p)
+		{
+			sum += x->b;
+			manager.Delete(x);
+		}
+	}
+	EXPECT_EQ(sum, 200000l * 64);
+}
@@ -0,0 +1,100 @@
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include <omem.hpp>
+
+namespace
+{
+	class BudgetResource final : public omem::ChunkResource
+	{
+	public:
+		explicit BudgetResource(size_t budget) noexcept :budget_{budget} {}
+
+		void* Allocate(size_t size) override
+		{
+			if (budget_ == 0) throw std::bad_alloc{};
+			--budget_;
+			return operator new(size);
+		}
+
+		void Deallocate(void* p, size_t) noexcept override { operator delete(p); }
+
+		size_t budget_;
+	};
+
+	struct Throwing
+	{
+		explicit Throwing(int x) { if (x < 0) throw std::runtime_error{"negative"}; }
+		char pad[24];
+	};
+
+	struct Pair
+	{
+		long a;
+		long b;
+	};
+}
+
+TEST(nothrow, pool)
+{
+	BudgetResource res{1};
+	omem::BasicMemoryPool<omem::AnyChunkProvider> pool{16, 2, res};
+	auto* const a = pool.Alloc(std::nothrow);
+	auto* const b = pool.Alloc(std::nothrow);
+	ASSERT_TRUE(a && b);
+	EXPECT_EQ(pool.Alloc(std::nothrow), nullptr);
+	EXPECT_THROW((void)pool.Alloc(), std::bad_alloc);
+	EXPECT_EQ(pool.GetInfo().cur, 2);
+	EXPECT_EQ(pool.GetInfo().fault, 0);
+	pool.Free(a);
+	pool.Free(b);
+}
+
+TEST(nothrow, manager)
+{
+	BudgetResource res{0};
+	omem::BasicMemoryPoolManager<omem::AnyChunkProvider> manager{res};
+	const auto before = omem::ThreadAllocated();
+	EXPECT_EQ(manager.Alloc(64, std::nothrow), nullptr);
+	EXPECT_EQ(manager.New<Pair>(std::nothrow, 1l, 2l), nullptr);
+	EXPECT_EQ(manager.NewArr<Pair>(std::nothrow, 4), nullptr);
+	EXPECT_EQ(omem::ThreadAllocated(), before);
+
+	res.budget_ = 1;
+	auto* const p = manager.New<Pair>(std::nothrow, 1l, 2l);
+	ASSERT_TRUE(p);
+	EXPECT_EQ(p->b, 2);
+	manager.Delete(p);
+
+	EXPECT_EQ(manager.NewArr<Pair>(std::nothrow, SIZE_MAX / 16 + 1), nullptr);
+	EXPECT_THROW((void)manager.NewArr<Pair>(SIZE_MAX / 16 + 1), std::bad_alloc);
+
+	static_assert(noexcept(manager.New<Pair>(std::nothrow, 1l, 2l)));
+	static_assert(noexcept(manager.Alloc(8, std::nothrow)));
+	static_assert(!noexcept(manager.New<Throwing>(std::nothrow, 1)));
+}
+
+TEST(nothrow, constructor)
+{
+	omem::MemoryPoolManager manager;
+	EXPECT_THROW((void)manager.New<Throwing>(std::nothrow, -1), std::runtime_error);
+	EXPECT_EQ(manager.Get(sizeof(Throwing)).GetInfo().cur, 0);
+	manager.Delete(manager.New<Throwing>(std::nothrow, 1));
+}
+
+// Same loop as noexcept.bench_new_delete in the -fno-exceptions build.
+TEST(nothrow, bench_new_delete)
+{
+	omem::MemoryPoolManager manager;
+	Pair* p[64];
+	long sum = 0;
+	for (auto i=0; i<200000; ++i)
+	{
+		for (auto& x : p) x = manager.New<Pair>(std::nothrow, long{i}, 1l);
+		for (auto* x : p)
+		{
+			sum += x->b;
+			manager.Delete(x);
+		}
+	}
+	EXPECT_EQ(sum, 200000l * 64);
+}
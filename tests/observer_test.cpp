@@ -0,0 +1,75 @@
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem/observer.hpp>
+
+TEST(observer, counting)
+{
+	const auto before = omem::CountingObserver::ThreadCounts();
+	{
+		omem::BasicMemoryPool<omem::NewChunkProvider, omem::CountingObserver> pool{16, 2};
+		static_assert(noexcept(pool.TryAlloc()));
+		auto* a = pool.Alloc();
+		auto* b = pool.Alloc();
+		auto* c = pool.Alloc();
+		pool.Free(a);
+		pool.Free(b);
+		EXPECT_EQ(pool.Trim(), 32);
+		EXPECT_EQ(pool.GetReserved(), 0);
+		pool.Free(c);
+
+		a = pool.Alloc();
+		EXPECT_TRUE(pool.Owns(a));
+		EXPECT_EQ(pool.Trim(), 0);
+		pool.Free(a);
+	}
+	const auto& after = omem::CountingObserver::ThreadCounts();
+	EXPECT_EQ(after.alloc - before.alloc, 3);
+	EXPECT_EQ(after.fault - before.fault, 1);
+	EXPECT_EQ(after.free - before.free, 4);
+	EXPECT_EQ(after.grow - before.grow, 2);
+	EXPECT_EQ(after.trim - before.trim, 1);
+	EXPECT_EQ(after.trimmed_bytes - before.trimmed_bytes, 32);
+}
+
+TEST(observer, trace)
+{
+	auto& ring = omem::TraceObserver::ThreadRing();
+	ring.Drain([](auto&) {});
+
+	omem::BasicMemoryPoolManager<omem::NewChunkProvider, omem::TraceObserver> manager;
+	manager.Free(manager.Alloc(24), 24);
+	EXPECT_EQ(manager.Trim(), manager.Get(24).GetInfo().size * manager.Get(24).GetInfo().count);
+
+	std::vector<omem::TraceEvent::Type> types;
+	ring.Drain([&](const omem::TraceEvent& e) { types.push_back(e.type); });
+	using T = omem::TraceEvent::Type;
+	EXPECT_EQ(types, (std::vector<T>{T::kGrow, T::kAlloc, T::kFree, T::kTrim}));
+	EXPECT_EQ(ring.Size(), 0);
+}
+
+template <class Pool>
+static void Benchmark()
+{
+	Pool pool{8, 1024};
+	void* p[64];
+	for (auto i=0; i<200000; ++i)
+	{
+		for (auto& x : p) x = pool.Alloc();
+		for (auto& x : p) pool.Free(x);
+	}
+}
+
+TEST(observer, bench_null)
+{
+	Benchmark<omem::BasicMemoryPool<omem::NewChunkProvider, omem::NullObserver>>();
+}
+
+TEST(observer, bench_counting)
+{
+	Benchmark<omem::BasicMemoryPool<omem::NewChunkProvider, omem::CountingObserver>>();
+}
+
+TEST(observer, bench_trace)
+{
+	Benchmark<omem::BasicMemoryPool<omem::NewChunkProvider, omem::TraceObserver>>();
+}
@@ -0,0 +1,165 @@
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem/pressure.hpp>
+
+#if OMEM_HAS_POSIX
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	void WriteFile(const std::string& path, const char* text)
+	{
+		auto* const file = std::fopen(path.c_str(), "w");
+		ASSERT_TRUE(file);
+		std::fputs(text, file);
+		std::fclose(file);
+	}
+}
+
+TEST(pressure, poll)
+{
+	const std::string path = "omem_pressure_test";
+	WriteFile(path, "some avg10=0.50 avg60=0.10 avg300=0.00 total=1234\nfull avg10=0.00 avg60=0.00 avg300=0.00 total=0\n");
+
+	omem::PressureMonitor monitor{path, 5.0};
+	omem::MemoryPoolManager manager;
+	manager.Free(manager.Alloc(64), 64);
+	const auto reserved = manager.Get(64).GetInfo().size * manager.Get(64).GetInfo().count;
+
+	const auto handle = monitor.Register([&] { return manager.Trim(); });
+	EXPECT_EQ(monitor.ReadAvg10(), 0.5);
+	EXPECT_EQ(monitor.Poll(), 0);
+	EXPECT_EQ(monitor.Epoch(), 0);
+
+	WriteFile(path, "some avg10=12.00 avg60=3.00 avg300=1.00 total=99999\n");
+	EXPECT_EQ(monitor.Poll(), reserved);
+	EXPECT_EQ(monitor.Epoch(), 1);
+	EXPECT_EQ(monitor.Poll(), 0);
+
+	monitor.Unregister(handle);
+	manager.Free(manager.Alloc(64), 64);
+	EXPECT_EQ(monitor.Poll(), 0);
+
+	uint64_t seen = 0;
+	EXPECT_EQ(monitor.Check(seen, manager), reserved);
+	EXPECT_EQ(seen, 3);
+	EXPECT_EQ(monitor.Check(seen, manager), 0);
+
+	// Callbacks run outside the monitor's lock, so one may unregister itself.
+	size_t once = 0;
+	once = monitor.Register([&] { monitor.Unregister(once); return size_t(1); });
+	EXPECT_EQ(monitor.Poll(), 1);
+	EXPECT_EQ(monitor.Poll(), 0);
+
+	std::remove(path.c_str());
+	EXPECT_FALSE(monitor.ReadAvg10());
+	EXPECT_EQ(monitor.Poll(), 0);
+}
+
+TEST(pressure, background)
+{
+	const std::string path = "omem_pressure_bg_test";
+	WriteFile(path, "some avg10=50.00 avg60=0.00 avg300=0.00 total=0\n");
+
+	omem::PressureMonitor monitor{path};
+	std::atomic<int> calls{0};
+	monitor.Register([&] { ++calls; return size_t(0); });
+	monitor.Start(std::chrono::milliseconds{1});
+	while (calls < 3) std::this_thread::yield();
+	monitor.Stop();
+	EXPECT_GE(monitor.Epoch(), 3);
+	std::remove(path.c_str());
+}
+
+#if OMEM_HAS_POSIX
+TEST(pressure, cgroup_limit)
+{
+	const std::string root = "omem_cgroup_test";
+	mkdir(root.c_str(), 0755);
+	mkdir((root + "/app").c_str(), 0755);
+	WriteFile(root + "/self", "12:cpu:/other\n0::/app\n");
+	WriteFile(root + "/app/memory.max", "max\n");
+	WriteFile(root + "/app/memory.high", "max\n");
+	const auto self = root + "/self";
+
+	EXPECT_EQ(omem::Config::ReadCgroupLimit(root.c_str(), self.c_str()), 0);
+	WriteFile(root + "/app/memory.max", "1073741824\n");
+	EXPECT_EQ(omem::Config::ReadCgroupLimit(root.c_str(), self.c_str()), 1 << 30);
+	WriteFile(root + "/app/memory.high", "536870912\n");
+	EXPECT_EQ(omem::Config::ReadCgroupLimit(root.c_str(), self.c_str()), 512 << 20);
+	EXPECT_EQ(omem::Config::ReadCgroupLimit(root.c_str(), "omem_cgroup_test/missing"), 0);
+
+	std::remove((root + "/app/memory.max").c_str());
+	std::remove((root + "/app/memory.high").c_str());
+	std::remove(self.c_str());
+	rmdir((root + "/app").c_str());
+	rmdir(root.c_str());
+}
+#endif
+
+TEST(pressure, memory_budget)
+{
+	omem::Config config;
+	config.Parse("pool_size:16m,pool_size.24:300,memory_budget:100m");
+	EXPECT_EQ(config.memory_budget, 100 << 20);
+	EXPECT_EQ(config.PoolSize(10), 1 << 20);
+	EXPECT_EQ(config.PoolSize(5), 512);
+
+	config.memory_budget = 0;
+	EXPECT_EQ(config.PoolSize(10), 16 << 20);
+
+	// The cgroup limit applies unless turned off or overridden.
+	EXPECT_TRUE(omem::Config{}.cgroup_limit);
+	EXPECT_EQ(omem::Config::FromEnvironment(nullptr, "cgroup_limit:false").memory_budget, 0);
+	EXPECT_EQ(omem::Config::FromEnvironment(nullptr, "memory_budget:1m").memory_budget, 1 << 20);
+}
+
+TEST(pressure, budget_enforced)
+{
+	// The budget is process-wide, so leave room for whatever other managers hold.
+	const auto used = omem::MemoryBudgetUsed();
+	omem::Config config;
+	config.Parse("pool_size:256");
+	config.memory_budget = used + 16384;
+	omem::MemoryPoolManager manager{config};
+
+	// The 64-byte pool reserves 256 bytes; 1k blocks are all faulted.
+	manager.Free(manager.Alloc(64), 64);
+	EXPECT_EQ(manager.Get(64).GetReserved(), 256);
+	std::vector<void*> blocks;
+	while (auto* const p = manager.Alloc(1024, std::nothrow)) blocks.push_back(p);
+
+	// The last block fit only once the idle 64-byte pool was trimmed.
+	EXPECT_EQ(blocks.size(), 16);
+	EXPECT_EQ(manager.Get(64).GetReserved(), 0);
+	EXPECT_EQ(omem::MemoryBudgetUsed() - used, 16384);
+	EXPECT_THROW((void)manager.Alloc(1024), std::bad_alloc);
+	EXPECT_THROW((void)manager.Alloc(64), std::bad_alloc);
+
+	for (auto* b : blocks) manager.Free(b, 1024);
+	EXPECT_EQ(omem::MemoryBudgetUsed(), used);
+	manager.Free(manager.Alloc(64), 64);
+	EXPECT_EQ(manager.Get(64).GetReserved(), 256);
+}
+
+TEST(pressure, watch)
+{
+	const std::string path = "omem_pressure_watch_test";
+	WriteFile(path, "some avg10=80.00 avg60=0.00 avg300=0.00 total=0\n");
+
+	omem::PressureMonitor monitor{path};
+	omem::MemoryPoolManager manager;
+	manager.Free(manager.Alloc(64), 64);
+	const auto reserved = manager.Get(64).GetReserved();
+	ASSERT_NE(reserved, 0);
+
+	const auto handle = monitor.Watch(manager);
+	EXPECT_EQ(monitor.Poll(), reserved);
+	EXPECT_EQ(manager.Get(64).GetReserved(), 0);
+	monitor.Unregister(handle);
+	std::remove(path.c_str());
+}
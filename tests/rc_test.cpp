@@ -0,0 +1,110 @@
+#include <memory>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem/rc.hpp>
+
+TEST(rc, lifetime)
+{
+	struct Counted
+	{
+		explicit Counted(int& live) :live{live} { ++live; }
+		~Counted() { --live; }
+		int& live;
+	};
+
+	int live = 0;
+	{
+		auto a = omem::MakeRc<Counted>(live);
+		EXPECT_EQ(live, 1);
+		auto b = a;
+		EXPECT_EQ(a.UseCount(), 2);
+		auto c = std::move(b);
+		EXPECT_FALSE(b);
+		EXPECT_EQ(a, c);
+		a.Reset();
+		EXPECT_EQ(c.UseCount(), 1);
+		EXPECT_EQ(live, 1);
+	}
+	EXPECT_EQ(live, 0);
+}
+
+TEST(rc, arc_threads)
+{
+	auto a = omem::MakeArc<std::vector<int>>(100, 1);
+	std::vector<std::thread> threads;
+	for (auto i=0; i<4; ++i)
+	{
+		threads.emplace_back([a]
+		{
+			for (auto j=0; j<10000; ++j)
+			{
+				auto copy = a;
+				auto other = omem::MakeArc<std::vector<int>>(*copy);
+				ASSERT_EQ(other->size(), 100);
+			}
+		});
+	}
+	for (auto& t : threads) t.join();
+	EXPECT_EQ(a.UseCount(), 1);
+}
+
+// Layered DAG: every node links to two nodes of the previous layer.
+template <template <class> class Ptr, class Make>
+static void Benchmark(Make make)
+{
+	struct Node
+	{
+		Ptr<Node> left, right;
+		long value;
+	};
+
+	constexpr auto kWidth = 256, kDepth = 64;
+	long sum = 0;
+	for (auto iter=0; iter<100; ++iter)
+	{
+		std::vector<Ptr<Node>> layer, next;
+		for (auto i=0; i<kWidth; ++i) layer.push_back(make(Node{{}, {}, i}));
+		for (auto d=1; d<kDepth; ++d)
+		{
+			next.clear();
+			for (auto i=0; i<kWidth; ++i)
+				next.push_back(make(Node{layer[i], layer[(i * 7 + 1) % kWidth], i}));
+			layer.swap(next);
+		}
+
+		std::vector<Ptr<Node>> stack;
+		for (auto& n : layer)
+		{
+			stack.push_back(n);
+			for (auto steps=0; steps<kDepth; ++steps)
+			{
+				auto cur = std::move(stack.back());
+				stack.pop_back();
+				sum += cur->value;
+				if (cur->left) stack.push_back(steps % 2 ? cur->left : cur->right);
+				if (stack.empty()) break;
+			}
+			stack.clear();
+		}
+	}
+	EXPECT_GT(sum, 0);
+}
+
+template <class T>
+using SharedPtr = std::shared_ptr<T>;
+
+TEST(rc, bench_rc)
+{
+	Benchmark<omem::Rc>([](auto&& n) { return omem::MakeRc<std::decay_t<decltype(n)>>(std::move(n)); });
+}
+
+TEST(rc, bench_arc)
+{
+	Benchmark<omem::Arc>([](auto&& n) { return omem::MakeArc<std::decay_t<decltype(n)>>(std::move(n)); });
+}
+
+TEST(rc, bench_shared_ptr)
+{
+	Benchmark<SharedPtr>([](auto&& n) { return std::make_shared<std::decay_t<decltype(n)>>(std::move(n)); });
+}
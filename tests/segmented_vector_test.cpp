@@ -0,0 +1,105 @@
+#include <deque>
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem/segmented_vector.hpp>
+
+TEST(segmented_vector, stable)
+{
+	omem::SegmentedVector<int, 64> v;
+	static_assert(decltype(v)::kSegmentSize == 16);
+
+	std::vector<int*> addrs;
+	for (auto i=0; i<100; ++i) addrs.push_back(&v.EmplaceBack(i));
+	EXPECT_EQ(v.SegmentCount(), 7);
+	for (auto i=0; i<100; ++i)
+	{
+		EXPECT_EQ(&v[i], addrs[i]);
+		EXPECT_EQ(v[i], i);
+	}
+
+	const auto cur = omem::ThreadPools().Get(64).GetInfo().cur;
+	v.Resize(32);
+	EXPECT_EQ(v.SegmentCount(), 2);
+	EXPECT_EQ(omem::ThreadPools().Get(64).GetInfo().cur, cur - 4);
+	v.PushBack(32);
+	EXPECT_EQ(omem::ThreadPools().Get(64).GetInfo().cur, cur - 4);
+
+	int sum = 0;
+	for (auto x : v) sum += x;
+	EXPECT_EQ(sum, 32 * 33 / 2);
+	EXPECT_EQ(std::lower_bound(v.begin(), v.end(), 20) - v.begin(), 20);
+
+	v.Clear();
+	EXPECT_EQ(omem::ThreadPools().Get(64).GetInfo().cur, cur - 6);
+}
+
+TEST(segmented_vector, throwing_constructor)
+{
+	struct Thrower
+	{
+		explicit Thrower(bool fail) { if (fail) throw 1; }
+		int x = 0;
+	};
+
+	omem::MemoryPoolManager manager;
+	{
+		omem::SegmentedVector<Thrower, 64> v{manager};
+		EXPECT_THROW(v.EmplaceBack(true), int);
+		EXPECT_EQ(v.SegmentCount(), 0);
+
+		for (auto i=0; i<16; ++i) v.EmplaceBack(false);
+		EXPECT_THROW(v.EmplaceBack(true), int);
+		EXPECT_EQ(v.SegmentCount(), 1);
+		EXPECT_EQ(v.Size(), 16);
+		v.EmplaceBack(false);
+		v.Clear();
+	}
+	EXPECT_EQ(manager.Get(64).GetInfo().cur, 0);
+}
+
+namespace
+{
+	constexpr auto kN = 1 << 22;
+
+	template <class V>
+	void PushBack(V& v, long x) { v.push_back(x); }
+
+	void PushBack(omem::SegmentedVector<long>& v, long x) { v.PushBack(x); }
+
+	template <class V>
+	void Benchmark(V& v)
+	{
+		for (auto r=0; r<4; ++r)
+		{
+			v = V{};
+			for (long i=0; i<kN; ++i) PushBack(v, i);
+		}
+
+		uint64_t x = 88172645463325252ull;
+		long sum = 0;
+		for (auto i=0; i<kN; ++i)
+		{
+			x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+			sum += v[x % kN];
+		}
+		EXPECT_GT(sum, 0);
+	}
+}
+
+TEST(segmented_vector, bench_omem)
+{
+	omem::SegmentedVector<long> v;
+	Benchmark(v);
+}
+
+TEST(segmented_vector, bench_vector)
+{
+	std::vector<long> v;
+	Benchmark(v);
+}
+
+TEST(segmented_vector, bench_deque)
+{
+	std::deque<long> v;
+	Benchmark(v);
+}
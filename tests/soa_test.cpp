@@ -0,0 +1,145 @@
+#include <stdexcept>
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem/soa.hpp>
+
+TEST(soa, handles)
+{
+	omem::BasicSoAPool<omem::NewChunkProvider, 4, 64, int, double> pool;
+	std::vector<decltype(pool)::Handle> h;
+	for (auto i=0; i<10; ++i) h.push_back(pool.Alloc(i, i * 0.5));
+	EXPECT_EQ(pool.ChunkCount(), 3);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(pool.Column<1>(1)) % 64, 0);
+
+	pool.Free(h[2]);
+	pool.Free(h[0]);
+	EXPECT_FALSE(pool.IsValid(h[2]));
+	EXPECT_EQ(pool.Size(), 8);
+	for (auto i : {1, 3, 4, 5, 6, 7, 8, 9})
+	{
+		EXPECT_EQ(pool.Get<0>(h[i]), i);
+		EXPECT_EQ(pool.Get<1>(h[i]), i * 0.5);
+	}
+
+	const auto reused = pool.Alloc();
+	EXPECT_TRUE(pool.IsValid(reused));
+	EXPECT_EQ(reused.index, h[0].index);
+	EXPECT_NE(reused.generation, h[0].generation);
+	EXPECT_EQ(pool.Get<0>(reused), 0);
+
+	int sum = 0;
+	pool.ForEachChunk<0>([&](size_t n, const int* col) { for (size_t i=0; i<n; ++i) sum += col[i]; });
+	EXPECT_EQ(sum, 45 - 2);
+}
+
+namespace
+{
+	struct Counted
+	{
+		static inline int live = 0;
+
+		explicit Counted(int x)
+		{
+			if (x < 0) throw std::runtime_error{"negative"};
+			++live;
+		}
+
+		Counted(Counted&&) noexcept { ++live; }
+		Counted& operator=(Counted&&) noexcept = default;
+		~Counted() { --live; }
+	};
+
+	class CountingResource final : public omem::ChunkResource
+	{
+	public:
+		void* Allocate(size_t size) override
+		{
+			bytes += size;
+			return operator new(size);
+		}
+
+		void Deallocate(void* p, size_t size) noexcept override
+		{
+			bytes -= size;
+			operator delete(p);
+		}
+
+		size_t bytes = 0;
+	};
+}
+
+TEST(soa, provider_and_exceptions)
+{
+	CountingResource res;
+	{
+		omem::BasicSoAPool<omem::AnyChunkProvider, 8, 128, Counted, Counted> pool{res};
+		const auto a = pool.Alloc(1, 2);
+		EXPECT_GT(res.bytes, 0);
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(pool.Column<1>(0)) % 128, 0);
+
+		EXPECT_THROW(pool.Alloc(3, -1), std::runtime_error);
+		EXPECT_EQ(Counted::live, 2);
+		EXPECT_EQ(pool.Size(), 1);
+		const auto b = pool.Alloc(4, 5);
+		EXPECT_EQ(b.index, a.index + 1);
+		EXPECT_EQ(Counted::live, 4);
+	}
+	EXPECT_EQ(Counted::live, 0);
+	EXPECT_EQ(res.bytes, 0);
+}
+
+namespace
+{
+	struct Particle
+	{
+		float x, y, z;
+		float vx, vy, vz;
+		float mass;
+		uint32_t flags;
+	};
+
+	constexpr auto kParticles = 1 << 20;
+	constexpr auto kIters = 20;
+}
+
+TEST(soa, bench_soa)
+{
+	omem::SoAPool<float, float, float, float, float, float, float, uint32_t> pool;
+	for (auto i=0; i<kParticles; ++i)
+		pool.Alloc(1.f, 2.f, 3.f, .5f, .5f, .5f, float(i % 7), uint32_t(i % 3 == 0));
+
+	double mass = 0;
+	for (auto it=0; it<kIters; ++it)
+	{
+		pool.ForEachChunk<6>([&](size_t n, const float* m)
+		{
+			float s = 0;
+			for (size_t i=0; i<n; ++i) s += m[i];
+			mass += s;
+		});
+		pool.ForEachChunk<0, 3, 7>([](size_t n, float* x, const float* vx, const uint32_t* flags)
+		{
+			for (size_t i=0; i<n; ++i) x[i] += flags[i] ? vx[i] : 0.f;
+		});
+	}
+	EXPECT_GT(mass, 0);
+}
+
+TEST(soa, bench_aos)
+{
+	omem::MemoryPoolManager pools;
+	std::vector<Particle*> particles;
+	for (auto i=0; i<kParticles; ++i)
+		particles.push_back(pools.New<Particle>(Particle{1.f, 2.f, 3.f, .5f, .5f, .5f, float(i % 7), uint32_t(i % 3 == 0)}));
+
+	double mass = 0;
+	for (auto it=0; it<kIters; ++it)
+	{
+		float s = 0;
+		for (auto* p : particles) s += p->mass;
+		mass += s;
+		for (auto* p : particles) if (p->flags) p->x += p->vx;
+	}
+	EXPECT_GT(mass, 0);
+	for (auto* p : particles) pools.Delete(p);
+}
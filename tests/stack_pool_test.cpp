@@ -0,0 +1,109 @@
+#include <cstring>
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem/stack_pool.hpp>
+
+#if OMEM_HAS_POSIX
+#include <ucontext.h>
+
+namespace
+{
+	size_t Resident(void* p, size_t size)
+	{
+		std::vector<unsigned char> vec(size / omem::PageSize());
+		EXPECT_EQ(mincore(p, size, vec.data()), 0);
+		size_t n = 0;
+		for (auto v : vec) n += v & 1;
+		return n;
+	}
+}
+
+TEST(stack_pool, reuse)
+{
+	omem::StackPool pool;
+	const auto s = pool.Alloc(100 << 10);
+	EXPECT_EQ(s.size, 128 << 10);
+	EXPECT_EQ(Resident(s.base, s.size), 0);
+
+	std::memset(s.base, 1, s.size);
+	EXPECT_EQ(Resident(s.base, s.size), s.size / omem::PageSize());
+
+	pool.Free(s);
+	EXPECT_EQ(pool.Cached(s.size), 1);
+	EXPECT_EQ(Resident(s.base, s.size), pool.Keep() / omem::PageSize());
+
+	const auto t = pool.Alloc(128 << 10);
+	EXPECT_EQ(t.base, s.base);
+	EXPECT_EQ(pool.Cached(s.size), 0);
+	pool.Free(t);
+
+	const auto big = pool.Alloc(2 << 20);
+	EXPECT_EQ(big.size, 2 << 20);
+	pool.Free(big);
+	EXPECT_EQ(pool.Cached(big.size), 0);
+}
+
+TEST(stack_pool, guard)
+{
+	const auto s = omem::ThreadStacks().Alloc(64 << 10);
+	static_cast<volatile char*>(s.Top())[-1] = 1;
+	EXPECT_DEATH(static_cast<volatile char*>(s.base)[-1] = 1, "");
+	omem::ThreadStacks().Free(s);
+}
+
+namespace
+{
+	constexpr auto kFibers = 100000;
+	constexpr size_t kStackSize = 256 << 10;
+
+	ucontext_t main_context;
+	long counter;
+
+	void FiberMain()
+	{
+		char frame[512];
+		std::memset(frame, 1, sizeof frame);
+		counter += frame[100];
+	}
+
+	void RunFiber(void* stack, size_t size)
+	{
+		ucontext_t fiber;
+		getcontext(&fiber);
+		fiber.uc_stack.ss_sp = stack;
+		fiber.uc_stack.ss_size = size;
+		fiber.uc_link = &main_context;
+		makecontext(&fiber, FiberMain, 0);
+		swapcontext(&main_context, &fiber);
+	}
+}
+
+TEST(stack_pool, bench_mmap)
+{
+	counter = 0;
+	const auto guard = omem::PageSize();
+	for (auto i=0; i<kFibers; ++i)
+	{
+		auto* const p = static_cast<char*>(mmap(nullptr, kStackSize + guard, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+		ASSERT_NE(p, MAP_FAILED);
+		mprotect(p, guard, PROT_NONE);
+		RunFiber(p + guard, kStackSize);
+		munmap(p, kStackSize + guard);
+	}
+	EXPECT_EQ(counter, kFibers);
+}
+
+TEST(stack_pool, bench_pool)
+{
+	counter = 0;
+	auto& stacks = omem::ThreadStacks();
+	for (auto i=0; i<kFibers; ++i)
+	{
+		const auto s = stacks.Alloc(kStackSize);
+		RunFiber(s.base, s.size);
+		stacks.Free(s);
+	}
+	EXPECT_EQ(counter, kFibers);
+}
+#endif
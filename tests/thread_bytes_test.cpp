@@ -0,0 +1,66 @@
+#include <new>
+#include <thread>
+#include <gtest/gtest.h>
+#include <omem.hpp>
+
+TEST(thread_bytes, counters)
+{
+	omem::MemoryPoolManager manager;
+	const auto* const allocated = omem::ThreadAllocatedPtr();
+	const auto* const deallocated = omem::ThreadDeallocatedPtr();
+	const auto a0 = *allocated;
+	const auto d0 = *deallocated;
+
+	auto* const p = manager.Alloc(100);
+	EXPECT_EQ(*allocated - a0, 100);
+	auto* const q = manager.Realloc(p, 100, 300);
+	EXPECT_EQ(*allocated - a0, 400);
+	EXPECT_EQ(*deallocated - d0, 100);
+	manager.Free(q, 300);
+	EXPECT_EQ(*deallocated - d0, 400);
+
+	auto* const x = manager.New<uint64_t>(uint64_t{1});
+	manager.Delete(x);
+	EXPECT_EQ(omem::ThreadAllocated() - a0, 408);
+	EXPECT_EQ(omem::ThreadDeallocated() - d0, 408);
+
+	// Failed allocations aren't counted.
+	EXPECT_THROW((void)manager.Alloc(SIZE_MAX), std::bad_alloc);
+	auto* const r = manager.Alloc(8);
+	EXPECT_THROW((void)manager.Realloc(r, 8, SIZE_MAX), std::bad_alloc);
+	manager.Free(r, 8);
+	EXPECT_EQ(omem::ThreadAllocated() - a0, 416);
+	EXPECT_EQ(omem::ThreadDeallocated() - d0, 416);
+
+	// Other threads have their own counters.
+	std::thread{[&]
+	{
+		EXPECT_NE(omem::ThreadAllocatedPtr(), allocated);
+		EXPECT_EQ(omem::ThreadAllocated(), 0);
+		auto& pools = omem::ThreadPools();
+		pools.Free(pools.Alloc(64), 64);
+		EXPECT_EQ(omem::ThreadAllocated(), 64);
+	}}.join();
+	EXPECT_EQ(*allocated - a0, 416);
+}
+
+TEST(thread_bytes, scope)
+{
+	auto& pools = omem::ThreadPools();
+	uint64_t bytes = 0;
+	{
+		omem::AllocationScope outer{&bytes};
+		auto* const p = pools.Alloc(32);
+		{
+			omem::AllocationScope inner;
+			pools.Free(pools.Alloc(16), 16);
+			EXPECT_EQ(inner.Allocated(), 16);
+			EXPECT_EQ(inner.Deallocated(), 16);
+		}
+		pools.Free(p, 32);
+		EXPECT_EQ(outer.Allocated(), 48);
+		EXPECT_EQ(outer.Deallocated(), 48);
+		EXPECT_EQ(bytes, 0);
+	}
+	EXPECT_EQ(bytes, 48);
+}
@@ -0,0 +1,121 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem/timeline.hpp>
+
+namespace
+{
+	std::string Dump(const omem::HeapTimeline& timeline, bool json)
+	{
+		auto* const file = std::tmpfile();
+		json ? timeline.WriteJson(file) : timeline.WriteCsv(file);
+		std::string text(static_cast<size_t>(std::ftell(file)), '\0');
+		std::rewind(file);
+		text.resize(std::fread(text.data(), 1, text.size(), file));
+		std::fclose(file);
+		return text;
+	}
+}
+
+TEST(timeline, record)
+{
+	omem::Config config;
+	config.Parse("pool_size:4k");
+	omem::MemoryPoolManager manager{config};
+	omem::HeapTimeline timeline{std::chrono::hours{1}, 4};
+
+	EXPECT_TRUE(timeline.Tick(manager));
+	EXPECT_FALSE(timeline.Tick(manager));
+
+	std::vector<void*> p(100);
+	for (auto& x : p) x = manager.Alloc(64);
+	timeline.Record(manager, "load");
+
+	std::vector<omem::TimelineSample> samples;
+	timeline.ForEach([&](auto& s) { samples.push_back(s); });
+	ASSERT_EQ(samples.size(), 2);
+	EXPECT_EQ(samples[0].classes, 0);
+	EXPECT_EQ(samples[0].event, nullptr);
+	EXPECT_STREQ(samples[1].event, "load");
+	EXPECT_EQ(samples[1].classes, 1 << 6);
+	EXPECT_EQ(samples[1].cls[6].cur, 100);
+	EXPECT_EQ(samples[1].cls[6].reserved, 4096);
+	EXPECT_EQ(samples[1].cls[6].fault, 36);
+	EXPECT_GT(samples[1].rss, 0);
+	EXPECT_GE(samples[1].time, samples[0].time);
+
+	for (auto i=0; i<10; ++i) timeline.Record(manager);
+	EXPECT_EQ(timeline.Size(), 4);
+	for (auto* x : p) manager.Free(x, 64);
+}
+
+TEST(timeline, trigger)
+{
+	omem::Config config;
+	config.Parse("pool_size:4k");
+	omem::MemoryPoolManager manager{config};
+	omem::HeapTimeline timeline{std::chrono::hours{1}, 8, 10, 2};
+	EXPECT_TRUE(timeline.Tick(manager));
+
+	std::vector<void*> p(70);
+	for (auto& x : p) x = manager.Alloc(64);
+	EXPECT_FALSE(timeline.Tick(manager));
+	for (auto i=0; i<10; ++i) p.push_back(manager.Alloc(64));
+	EXPECT_TRUE(timeline.Tick(manager));
+	EXPECT_FALSE(timeline.Tick(manager));
+
+	timeline.Record(manager);
+	EXPECT_FALSE(timeline.Frozen());
+	timeline.Record(manager);
+	EXPECT_TRUE(timeline.Frozen());
+	timeline.Record(manager);
+	for (auto i=0; i<20; ++i) p.push_back(manager.Alloc(64));
+	EXPECT_FALSE(timeline.Tick(manager));
+	EXPECT_EQ(timeline.Size(), 4);
+
+	std::vector<const char*> events;
+	timeline.ForEach([&](auto& s) { events.push_back(s.event); });
+	EXPECT_STREQ(events[1], "fault_spike");
+
+	timeline.Resume();
+	EXPECT_TRUE(timeline.Tick(manager));
+	EXPECT_EQ(timeline.Size(), 5);
+	for (auto* x : p) manager.Free(x, 64);
+}
+
+TEST(timeline, dump)
+{
+	omem::Config config;
+	config.Parse("pool_size:4k");
+	omem::MemoryPoolManager manager{config};
+	omem::HeapTimeline timeline;
+	timeline.Record(manager, "start");
+	auto* const a = manager.Alloc(16);
+	auto* const b = manager.Alloc(200);
+	timeline.Record(manager);
+
+	const auto csv = Dump(timeline, false);
+	EXPECT_EQ(csv.rfind("time_ns,rss,event,size,cur,reserved,fault\n", 0), 0);
+	EXPECT_NE(csv.find(",start,0,0,0,0\n"), std::string::npos);
+	EXPECT_NE(csv.find(",,16,1,4096,0\n"), std::string::npos);
+	EXPECT_NE(csv.find(",,256,1,4096,0\n"), std::string::npos);
+
+	const auto json = Dump(timeline, true);
+	EXPECT_EQ(json.front(), '[');
+	EXPECT_NE(json.find("\"event\":\"start\",\"classes\":[]}"), std::string::npos);
+	EXPECT_NE(json.find("\"event\":null,\"classes\":[{\"size\":16,\"cur\":1,\"reserved\":4096,\"fault\":0},{\"size\":256"), std::string::npos);
+
+	manager.Free(a, 16);
+	manager.Free(b, 200);
+}
+
+// Cost of a Tick() that doesn't sample, the common case in a hot loop.
+TEST(timeline, bench_tick)
+{
+	omem::MemoryPoolManager manager;
+	omem::HeapTimeline timeline{std::chrono::hours{1}};
+	size_t samples = 0;
+	for (auto i=0; i<1000000; ++i) samples += timeline.Tick(manager);
+	EXPECT_EQ(samples, 1);
+}
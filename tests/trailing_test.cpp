@@ -0,0 +1,130 @@
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem.hpp>
+
+namespace
+{
+	struct Header
+	{
+		explicit Header(size_t n) :size{n}
+		{
+			auto* const elems = omem::Trailing<double>(this);
+			for (size_t i=0; i<n; ++i) elems[i] = double(i);
+		}
+
+		size_t size;
+		char tag = 'h';
+	};
+
+	struct Throwing
+	{
+		Throwing()
+		{
+			if (++count == 3) throw std::runtime_error{"third"};
+		}
+
+		~Throwing() { --count; }
+
+		static inline int count = 0;
+	};
+}
+
+TEST(trailing, layout)
+{
+	omem::MemoryPoolManager manager;
+	auto* const h = manager.NewWithTrailing<Header, double>(5, size_t(5));
+	auto* const elems = omem::Trailing<double>(h);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(elems) % alignof(double), 0);
+	EXPECT_GE(reinterpret_cast<char*>(elems), reinterpret_cast<char*>(h) + sizeof(Header));
+	EXPECT_EQ(elems[4], 4.0);
+	EXPECT_EQ(manager.Get(sizeof(Header) + 5 * sizeof(double)).GetInfo().cur, 1);
+	manager.DeleteWithTrailing<Header, double>(h, 5);
+	EXPECT_EQ(manager.Get(sizeof(Header) + 5 * sizeof(double)).GetInfo().cur, 0);
+
+	auto* const s = manager.NewWithTrailing<int, std::string>(3, 7);
+	EXPECT_EQ(*s, 7);
+	EXPECT_TRUE(omem::Trailing<std::string>(static_cast<const int*>(s))[2].empty());
+	manager.DeleteWithTrailing<int, std::string>(s, 3);
+}
+
+TEST(trailing, exception)
+{
+	omem::MemoryPoolManager manager;
+	EXPECT_THROW(((void)manager.NewWithTrailing<int, Throwing>(5)), std::runtime_error);
+	EXPECT_EQ(Throwing::count, 1);
+	EXPECT_EQ(manager.Get(sizeof(int) + 5).GetInfo().cur, 0);
+
+	EXPECT_THROW(((void)manager.NewWithTrailing<int, double>(SIZE_MAX / 8)), std::bad_alloc);
+	EXPECT_THROW(((void)manager.NewWithTrailing<int, char>(SIZE_MAX - 2)), std::bad_alloc);
+}
+
+namespace
+{
+	constexpr auto kObjects = 1 << 18;
+	constexpr auto kElems = 12;
+	constexpr auto kRounds = 25;
+
+	struct Split
+	{
+		size_t size;
+		int* elems;
+	};
+
+	struct Packed
+	{
+		size_t size;
+	};
+
+	template <class Get>
+	long Walk(size_t count, Get&& get)
+	{
+		long sum = 0;
+		uint64_t x = 88172645463325252ull;
+		for (auto r=0; r<kRounds; ++r)
+		{
+			for (size_t i=0; i<count; ++i)
+			{
+				x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+				sum += get(x % count, x % kElems);
+			}
+		}
+		return sum;
+	}
+}
+
+TEST(trailing, bench_separate)
+{
+	auto& pools = omem::ThreadPools();
+	std::vector<Split*> objects(kObjects);
+	for (auto& o : objects)
+	{
+		o = pools.New<Split>(size_t(kElems), pools.NewArr<int>(kElems));
+		for (auto i=0; i<kElems; ++i) o->elems[i] = i;
+	}
+
+	EXPECT_GT(Walk(kObjects, [&](size_t i, size_t j) { return long(objects[i]->size) + objects[i]->elems[j]; }), 0);
+
+	for (auto* o : objects)
+	{
+		pools.DeleteArr(o->elems, kElems);
+		pools.Delete(o);
+	}
+}
+
+TEST(trailing, bench_trailing)
+{
+	auto& pools = omem::ThreadPools();
+	std::vector<Packed*> objects(kObjects);
+	for (auto& o : objects)
+	{
+		o = pools.NewWithTrailing<Packed, int>(kElems, size_t(kElems));
+		for (auto i=0; i<kElems; ++i) omem::Trailing<int>(o)[i] = i;
+	}
+
+	EXPECT_GT(Walk(kObjects, [&](size_t i, size_t j) { return long(objects[i]->size) + omem::Trailing<int>(objects[i])[j]; }), 0);
+
+	for (auto* o : objects) pools.DeleteWithTrailing<Packed, int>(o, kElems);
+}
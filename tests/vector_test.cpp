@@ -0,0 +1,221 @@
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <omem/chunk.hpp>
+#include <omem/vector.hpp>
+
+TEST(vector, basic)
+{
+	omem::Vector<int> v;
+	for (auto i=0; i<1000; ++i) v.PushBack(i);
+	EXPECT_EQ(v.Size(), 1000);
+	EXPECT_EQ(v.Capacity(), 1024);
+	for (auto i=0; i<1000; ++i) ASSERT_EQ(v[i], i);
+
+	v.Resize(10);
+	EXPECT_EQ(v.Back(), 9);
+	v.PopBack();
+	EXPECT_EQ(v.Size(), 9);
+	EXPECT_EQ(v.Capacity(), 1024);
+
+	auto sum = 0;
+	for (auto x : v) sum += x;
+	EXPECT_EQ(sum, 36);
+
+	auto w = std::move(v);
+	EXPECT_TRUE(v.Empty());
+	EXPECT_EQ(w.Front(), 0);
+}
+
+TEST(vector, capacity_fills_class)
+{
+	omem::Vector<char> v;
+	v.PushBack('a');
+	EXPECT_EQ(v.Capacity(), omem::ThreadPools().UsableSize(1));
+
+	const auto* const data = v.Data();
+	while (v.Size() < v.Capacity()) v.PushBack('b');
+	EXPECT_EQ(v.Data(), data);
+}
+
+TEST(vector, reserve_overflow)
+{
+	omem::Vector<uint64_t> v;
+	EXPECT_THROW(v.Reserve(SIZE_MAX / sizeof(uint64_t) + 1), std::bad_alloc);
+	EXPECT_THROW(v.Reserve(SIZE_MAX / 4), std::bad_alloc);
+	EXPECT_EQ(v.Capacity(), 0);
+	EXPECT_EQ(omem::ThreadPools().UsableSize(SIZE_MAX), SIZE_MAX);
+}
+
+TEST(vector, non_relocatable)
+{
+	omem::Vector<std::string> v;
+	for (auto i=0; i<100; ++i) v.EmplaceBack(50, char('a' + i % 26));
+	for (auto i=0; i<100; ++i) ASSERT_EQ(v[i], std::string(50, char('a' + i % 26)));
+	v.Clear();
+	EXPECT_EQ(v.Size(), 0);
+}
+
+TEST(vector, push_own_element)
+{
+	omem::Vector<long> v;
+	omem::Vector<std::string> s;
+	v.PushBack(1);
+	s.PushBack(std::string(50, 'x'));
+	for (auto i=0; i<10; ++i)
+	{
+		ASSERT_EQ(v.Size(), v.Capacity());
+		v.PushBack(v[0]);
+		ASSERT_EQ(v.Back(), 1);
+		v.Resize(v.Capacity());
+
+		while (s.Size() < s.Capacity()) s.PushBack(s[0]);
+		s.PushBack(s[0]);
+	}
+	for (auto& x : s) ASSERT_EQ(x, std::string(50, 'x'));
+}
+
+namespace
+{
+	struct ThrowingMove
+	{
+		static inline int moves = 0;
+
+		ThrowingMove() = default;
+		ThrowingMove(ThrowingMove&&)
+		{
+			if (++moves == 3) throw std::runtime_error{"move"};
+		}
+	};
+}
+
+TEST(vector, throwing_move)
+{
+	omem::Vector<ThrowingMove> v;
+	while (v.Size() < 4) v.EmplaceBack();
+	ThrowingMove::moves = 0;
+	const auto* const data = v.Data();
+	const auto cur = omem::ThreadPools().Get(v.Capacity() * 2 * sizeof(ThrowingMove)).GetInfo().cur;
+	EXPECT_THROW(v.Reserve(v.Capacity() * 2), std::runtime_error);
+	EXPECT_EQ(v.Data(), data);
+	EXPECT_EQ(v.Size(), 4);
+	EXPECT_EQ(omem::ThreadPools().Get(v.Capacity() * 2 * sizeof(ThrowingMove)).GetInfo().cur, cur);
+}
+
+namespace
+{
+	struct CopyableThrowingMove
+	{
+		static inline int moves = 0;
+		static inline bool fail = false;
+		int x = 0;
+
+		explicit CopyableThrowingMove(int x) : x{x}
+		{
+			if (fail) throw std::runtime_error{"construct"};
+		}
+		CopyableThrowingMove(const CopyableThrowingMove&) = default;
+		CopyableThrowingMove(CopyableThrowingMove&& r) : x{r.x} { ++moves; }
+	};
+}
+
+TEST(vector, copy_if_move_throws)
+{
+	omem::Vector<CopyableThrowingMove> v;
+	for (auto i=0; i<100; ++i) v.EmplaceBack(i);
+	EXPECT_EQ(CopyableThrowingMove::moves, 0);
+
+	while (v.Size() < v.Capacity()) v.EmplaceBack(0);
+	const auto* const data = v.Data();
+	const auto size = v.Size();
+	CopyableThrowingMove::fail = true;
+	EXPECT_THROW(v.EmplaceBack(1), std::runtime_error);
+	CopyableThrowingMove::fail = false;
+	EXPECT_EQ(v.Data(), data);
+	EXPECT_EQ(v.Size(), size);
+	for (auto i=0; i<100; ++i) ASSERT_EQ(v[i].x, i);
+}
+
+#if OMEM_HAS_POSIX
+TEST(vector, realloc)
+{
+	omem::BasicMemoryPoolManager<omem::MmapChunkProvider> pools;
+	const size_t big = OMEM_POOL_SIZE * 2;
+	auto* p = static_cast<char*>(pools.Alloc(big));
+	p[0] = 1;
+	p[big - 1] = 2;
+	p = static_cast<char*>(pools.Realloc(p, big, big * 2));
+	EXPECT_EQ(p[0], 1);
+	EXPECT_EQ(p[big - 1], 2);
+	EXPECT_EQ(pools.Get(big).GetInfo().cur, 0);
+	EXPECT_EQ(pools.Get(big * 2).GetInfo().cur, 1);
+
+	auto* q = static_cast<char*>(pools.Realloc(p, big * 2, 16));
+	EXPECT_EQ(q[0], 1);
+	EXPECT_EQ(pools.Get(big * 2).GetInfo().cur, 0);
+	EXPECT_EQ(pools.Realloc(q, 16, 15), q);
+	pools.Free(q, 15);
+}
+#endif
+
+namespace
+{
+	constexpr auto kN = 1 << 23;
+
+	template <class T>
+	struct PoolAllocator
+	{
+		using value_type = T;
+
+		PoolAllocator() noexcept = default;
+		template <class U> PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+		T* allocate(size_t n) { return static_cast<T*>(omem::ThreadPools().Alloc(n * sizeof(T))); }
+		void deallocate(T* p, size_t n) noexcept { omem::ThreadPools().Free(p, n * sizeof(T)); }
+
+		template <class U> bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+		template <class U> bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+	};
+
+	template <class V>
+	void PushBack(V& v, long x) { v.push_back(x); }
+
+	template <class M>
+	void PushBack(omem::Vector<long, M>& v, long x) { v.PushBack(x); }
+
+	template <class V, class... Args>
+	void Benchmark(Args&... args)
+	{
+		for (auto r=0; r<8; ++r)
+		{
+			V v{args...};
+			for (long i=0; i<kN; ++i) PushBack(v, i);
+			EXPECT_EQ(v[kN - 1], kN - 1);
+		}
+	}
+}
+
+TEST(vector, bench_omem)
+{
+	Benchmark<omem::Vector<long>>();
+}
+
+#if OMEM_HAS_POSIX
+TEST(vector, bench_omem_mmap)
+{
+	omem::BasicMemoryPoolManager<omem::MmapChunkProvider> pools;
+	Benchmark<omem::Vector<long, decltype(pools)>>(pools);
+}
+#endif
+
+TEST(vector, bench_vector)
+{
+	Benchmark<std::vector<long>>();
+}
+
+TEST(vector, bench_vector_omem)
+{
+	Benchmark<std::vector<long, PoolAllocator<long>>>();
+}